@@ -73,6 +73,46 @@ struct move: public metl::abstract_move<cell2switch> {
     return G;
   }
 
+  // the neighborhood sends the moves of a cell in blocks. The handover
+  // costs of the cell to every switch and the residual capacities are
+  // computed once per block instead of once per move.
+  enum { batch_size = 32 };
+
+  static void cost_batch(const cell2switch::sol_t &sol, const move* moves, 
+			 cell2switch::eval_t* costs, unsigned n) {
+    const cell2switch& instance = cell2switch::instance();
+    std::vector<float> cap_resi;
+    instance.compute_cap_resi(cap_resi, sol);
+
+    std::vector<cell2switch::eval_t> H(instance.get_nswitch());
+    bool h_valid=false;
+    unsigned h_cell=0;
+
+    for (unsigned k=0; k<n; ++k) {
+      const unsigned c = moves[k].c;
+      const unsigned s = moves[k].s;
+      if (sol[c]==s) {
+	costs[k] = std::numeric_limits<cell2switch::eval_t>::max();
+	continue;
+      }
+
+      if (!h_valid || h_cell!=c) {
+	// H[x] is the handover cost between cell c and the cells of switch x
+	std::fill(H.begin(), H.end(), 0);
+	for (unsigned i=0; i<instance.get_ncell(); ++i) {
+	  if (i==c) continue;
+	  H[sol[i]] += (instance.h_cost(c,i) + instance.h_cost(i,c));
+	}
+	h_valid = true;
+	h_cell = c;
+      }
+
+      costs[k] = H[sol[c]] - H[s] 
+	+ instance.c_cost(c,s) - instance.c_cost(c,sol[c])
+	+ delta_penality(cap_resi[sol[c]], cap_resi, c, s);
+    }
+  }
+
   // effectue le mouvement sur la solution sol
   void operator()(cell2switch::sol_t &sol) const {
     assert(sol[c]!=s);
@@ -90,6 +130,14 @@ private:
 };
 
 
+// two moves conflict if they move the same cell
+struct move_conflicts {
+  bool operator()(const move& a, const move& b) const {
+    return a.get_c()==b.get_c();
+  }
+};
+
+
 //  std::ostream& operator<<(std::ostream& x , const move& m)
 //  {
 //    x<<"c: " <<m.c<<" s: "<<m.s;
@@ -131,12 +179,15 @@ public:
 
   template <class _oper>
   void iteration(_oper& op, const cell2switch::sol_t& sol, unsigned c) {
+    metl::move_block<cell2switch, _oper, move> blk(op, sol);
     for (unsigned s=0; s<switches; ++s) {
       if (sol[c]==s) continue;
-      op(move(c, s));
+      blk(move(c, s));
     }
+    blk.flush();
   }
   unsigned size() const { return cells; }
+  unsigned work(unsigned c) const { return switches-1; }
 };
 
 
@@ -158,7 +209,24 @@ public:
   }
 private:
    Matrix<unsigned> t_list;
+
+  friend struct metl::wire<tabu_list>;
+};
+
+
+// the tabu list in the checkpoints
+namespace metl {
+template <>
+struct wire<tabu_list> {
+  static void encode(const tabu_list& x, std::vector<char>& buf) {
+    wire<Matrix<unsigned> >::encode(x.t_list, buf);
+  }
+
+  static const char* decode(const char* p, tabu_list& x) {
+    return wire<Matrix<unsigned> >::decode(p, x.t_list);
+  }
 };
+}
 
 
 struct gain : public 
@@ -254,6 +322,7 @@ metl::abstract_gain<cell2switch, move, Matrix<cell2switch::eval_t>::iterator>
 	    }
 	    else
 	      Gcap(c,s) = std::numeric_limits<cell2switch::eval_t>::max();
+	    changed(c*nbr_comm+s);
 	  }
       } else {
 	// tous les mouvements vers Acomm et comm changent de penalite
@@ -265,10 +334,15 @@ metl::abstract_gain<cell2switch, move, Matrix<cell2switch::eval_t>::iterator>
 	  Gcap(c,comm) = G(c,comm)+delta_penality(cap_resi[sol[c]],cap_resi,c,comm);
 	else
 	  Gcap(c,comm) = std::numeric_limits<cell2switch::eval_t>::max();
+	changed(c*nbr_comm+Acomm);
+	changed(c*nbr_comm+comm);
       }
     }
   }
 
+  // update_before logs the entries of Gcap it writes (see sorted_gain)
+  bool logs_changes() const { return true; }
+
   iterator begin() {
     return Gcap.begin();
   }
@@ -318,12 +392,22 @@ int _main(int argc, char* argv[]) {
     cell2switch_descent_fm;
   test_generator(&cell2switch_descent_fm);
 
+  // using descent that applies several compatible moves per evaluation
+  descent_multi<cell2switch, move, neighborhood, move_conflicts, init_sol_gen> 
+    cell2switch_descent_multi(32);
+  test_generator(&cell2switch_descent_multi);
+
   // using tabu search  (with a gain structure)
   tabu_gain<cell2switch, move, gain, tabu_list,init_sol_gen> 
     cell2switch_ts_g(10, 1000);
   
   test_generator(&cell2switch_ts_g);
 
+  // same, the best admissible move is found without a full scan
+  tabu_gain<cell2switch, move, sorted_gain<gain>, tabu_list,init_sol_gen> 
+    cell2switch_ts_sg(10, 1000);
+  test_generator(&cell2switch_ts_sg);
+
   evolution<cell2switch, descent_fm<cell2switch, move, neighborhood, init_sol_gen>, uniform_xover<cell2switch>, cell2switch_mutation, tabu_gain<cell2switch, move, gain, tabu_list> >
     cell2switch_evo2(10, 200,0.2);
   
@@ -342,12 +426,27 @@ int _main(int argc, char* argv[]) {
     cell2switch_descent2;
   test_generator<cell2switch>(&cell2switch_descent2);
 
+  // using parallel descent that applies several moves per evaluation
+  descent_multi_ns_omp<cell2switch, move, neighborhood, move_conflicts, init_sol_gen> 
+    cell2switch_descent_multi2;
+  test_generator<cell2switch>(&cell2switch_descent_multi2);
+
+  // using parallel descent that accept first improving move
+  descent_fm_ns_omp<cell2switch, move, neighborhood, init_sol_gen> 
+    cell2switch_descent_fm2;
+  test_generator<cell2switch>(&cell2switch_descent_fm2);
+
 
   // using tabu search  (parallel version)
   tabu_ns_omp<cell2switch, move, neighborhood, tabu_list, init_sol_gen> 
     cell2switch_ts_omp(10, 10000);
   test_generator<cell2switch>(&cell2switch_ts_omp);
 
+  // same, but with a pool of threads started once for the whole search
+  tabu_ns_omp_pool<cell2switch, move, neighborhood, tabu_list, init_sol_gen> 
+    cell2switch_ts_pool(10, 10000);
+  test_generator<cell2switch>(&cell2switch_ts_pool);
+
 
 #endif
 
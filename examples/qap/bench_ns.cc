@@ -0,0 +1,90 @@
+// Scaling of the parallel algorithms based on neighborhood separation
+// (descent_ns_omp, tabu_ns_omp and their thread pool versions) with the
+// number of OpenMP threads.
+//
+// usage: bench_ns qaplib_file [max_threads] [tabu_iterations]
+//
+// The number of threads is doubled from 1 to max_threads (default 64).
+// Every run starts from the same solutions so the times can be compared.
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include "qap_prob.hh"
+#include "qap_oper.hh"
+#include "meta_algos.hh"
+#include "meta_main.hh"
+#include "../test_functions.h"
+
+using namespace metl;
+
+
+template <class _descent>
+double time_descents(_descent& descent, const std::vector<qap_prob::soleval_t>& starts) 
+{
+  timeval t0, t1;
+  gettimeofday(&t0,0);
+  for (unsigned i=0; i<starts.size(); ++i)
+    descent(starts[i]);
+  gettimeofday(&t1,0);
+  return dt(t1,t0);
+}
+
+
+template <class _tabu>
+double time_tabu(_tabu& ts, const qap_prob::soleval_t& start) 
+{
+  timeval t0, t1;
+  gettimeofday(&t0,0);
+  ts(start);
+  gettimeofday(&t1,0);
+  return dt(t1,t0);
+}
+
+
+int _main(int argc, char* argv[])
+{
+  qap_prob::instance().load(argv[1]);
+  const int max_threads = argc>2 ? atoi(argv[2]) : 64;
+  const unsigned n_iter = argc>3 ? atoi(argv[3]) : 2000;
+  const unsigned n = qap_prob::instance().size();
+
+  typedef descent_ns_omp<qap_prob, move, neighborhood, qap_gen> descent_t;
+  typedef tabu_ns_omp<qap_prob, move, neighborhood, tabu_list, qap_gen> tabu_t;
+  typedef descent_ns_omp_pool<qap_prob, move, neighborhood, qap_gen> descent_pool_t;
+  typedef tabu_ns_omp_pool<qap_prob, move, neighborhood, tabu_list, qap_gen> tabu_pool_t;
+
+  // the descents are short, so do a few of them from different solutions
+  std::vector<qap_prob::soleval_t> starts(10);
+  qap_gen gen;
+  for (unsigned i=0; i<starts.size(); ++i)
+    starts[i] = gen();
+
+  double t1_times[4];
+  std::cout << "threads\tdescent_ns_omp\tspeedup\ttabu_ns_omp\tspeedup"
+	    << "\tdescent_ns_omp_pool\tspeedup\ttabu_ns_omp_pool\tspeedup" << std::endl;
+
+  for (int t=1; t<=max_threads; t*=2) {
+    omp_set_num_threads(t);
+
+    descent_t descent;
+    descent_pool_t descent_pool;
+    tabu_t ts(n, n_iter);
+    tabu_pool_t ts_pool(n, n_iter);
+
+    double times[4];
+    times[0] = time_descents(descent, starts);
+    times[1] = time_tabu(ts, starts[0]);
+    times[2] = time_descents(descent_pool, starts);
+    times[3] = time_tabu(ts_pool, starts[0]);
+
+    std::cout << t;
+    for (unsigned i=0; i<4; ++i) {
+      if (t==1) t1_times[i] = times[i];
+      std::cout << "\t" << times[i] << "\t" << t1_times[i]/times[i];
+    }
+    std::cout << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,80 @@
+// Synchronous against asynchronous ring cooperation (omp_ring_coop and
+// omp_ring_coop::set_async) of robust tabu searches: wall time and
+// quality of the final solution.
+//
+// usage: bench_ring qaplib_file [threads] [runs] [exchange_period] [tabu_iterations]
+//
+// Both rings start each run from the same solution.
+
+#include <iostream>
+#include <cstdlib>
+#include "qap_prob.hh"
+#include "qap_oper.hh"
+#include "meta_algos.hh"
+#include "meta_main.hh"
+#include "../test_functions.h"
+
+using namespace metl;
+
+
+template <class _ring>
+double time_ring(_ring& ring, const qap_prob::soleval_t& start, qap_prob::eval_t& result) 
+{
+  timeval t0, t1;
+  gettimeofday(&t0,0);
+  result = ring(start).second;
+  gettimeofday(&t1,0);
+  return dt(t1,t0);
+}
+
+
+int _main(int argc, char* argv[])
+{
+  qap_prob::instance().load(argv[1]);
+  const int threads = argc>2 ? atoi(argv[2]) : omp_get_max_threads();
+  const unsigned runs = argc>3 ? atoi(argv[3]) : 10;
+  const unsigned period = argc>4 ? atoi(argv[4]) : 50;
+  const unsigned n_iter = argc>5 ? atoi(argv[5]) : 5000;
+  const unsigned n = qap_prob::instance().size();
+
+  typedef tabu_gain<qap_prob, move, gain, tabu_list, qap_gen> tabu_t;
+
+  omp_set_num_threads(threads);
+
+  omp_ring_coop<tabu_t> sync_ring(period);
+  omp_ring_coop<tabu_t> async_ring(period);
+  async_ring.set_async(true);
+
+  omp_ring_coop<tabu_t>* rings[2] = {&sync_ring, &async_ring};
+  for (unsigned i=0; i<2; ++i) {
+    rings[i]->set_n_iter(n_iter);
+    rings[i]->set_tenur_in(n);
+    rings[i]->set_tenur_out(n);
+  }
+
+  qap_gen gen;
+  double sum_t[2] = {0, 0};
+  double sum_eval[2] = {0, 0};
+
+  std::cout << "run\tsync_time\tsync_eval\tasync_time\tasync_eval" << std::endl;
+  for (unsigned r=0; r<runs; ++r) {
+    const qap_prob::soleval_t start = gen();
+
+    std::cout << r;
+    for (unsigned i=0; i<2; ++i) {
+      qap_prob::eval_t result;
+      const double t = time_ring(*rings[i], start, result);
+      sum_t[i] += t;
+      sum_eval[i] += result;
+      std::cout << "\t" << t << "\t" << result;
+    }
+    std::cout << std::endl;
+  }
+
+  std::cout << "mean";
+  for (unsigned i=0; i<2; ++i)
+    std::cout << "\t" << sum_t[i]/runs << "\t" << sum_eval[i]/runs;
+  std::cout << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,136 @@
+// Time to target of robust tabu searches cooperating as islands on the
+// topologies of topology.hh (omp_topology_coop_op): ring, 2D torus,
+// hypercube, random regular graph and gossip.
+//
+// usage: bench_topology qaplib_file target [threads] [runs] [exchange_period] [tabu_iterations]
+//
+// The time to target is the time until the solution of one of the
+// islands is at most target, it is checked at every exchange. Every
+// topology starts each run from the same solution.
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include "qap_prob.hh"
+#include "qap_oper.hh"
+#include "meta_algos.hh"
+#include "meta_main.hh"
+#include "../test_functions.h"
+
+using namespace metl;
+
+typedef tabu_gain<qap_prob, move, gain, tabu_list, qap_gen> tabu_t;
+
+
+// only the cooperations can run a metaheuristic with an exchange
+// operation, this one does it for the benchmark
+struct island : public tabu_t {
+  island(unsigned tabu_tenur, unsigned n_iter) : tabu_t(tabu_tenur, n_iter) {}
+
+  template <class PE>
+  qap_prob::soleval_t run(const qap_prob::soleval_t& se, PE& periodic_exchange) {
+    return tabu_t::operator()(se, periodic_exchange);
+  }
+};
+
+
+// notes the first time a solution reaches the target
+template <class _topology>
+struct timed_op : public omp_topology_coop_op<qap_prob, _topology> {
+  typedef omp_topology_coop_op<qap_prob, _topology> base;
+
+  timed_op(unsigned exchange_period, boost::shared_array<published_solution<qap_prob> >& published, const _topology& topology,
+	   qap_prob::eval_t _target, const timeval& _t0, double& _hit)
+    : base(exchange_period, published, topology),
+      target(_target), t0(_t0), hit(_hit)
+  {}
+
+  void send(const qap_prob::soleval_t& se) {
+    if (se.second <= target) {
+      timeval t1;
+      gettimeofday(&t1,0);
+#pragma omp critical (BENCH_TOPOLOGY_HIT)
+      {
+	if (hit<0) hit = dt(t1,t0);
+      }
+    }
+    base::send(se);
+  }
+
+  const qap_prob::eval_t target;
+  const timeval& t0;
+  double& hit;
+};
+
+
+template <class _topology>
+void bench(const _topology& topo, const std::vector<qap_prob::soleval_t>& starts, qap_prob::eval_t target, 
+	   unsigned period, unsigned n_iter)
+{
+  const unsigned n = qap_prob::instance().size();
+  double sum_ttt=0, sum_t=0, sum_eval=0;
+  unsigned hits=0;
+
+  for (unsigned r=0; r<starts.size(); ++r) {
+    boost::shared_array<published_solution<qap_prob> > published(new published_solution<qap_prob>[omp_get_max_threads()]);
+    qap_prob::soleval_t best = starts[r];
+    double hit=-1;
+    timeval t0, t1;
+    gettimeofday(&t0,0);
+
+#pragma omp parallel 
+    {
+      island ts(n, n_iter);
+      ts.set_tenur_in(n);
+      ts.set_tenur_out(n);
+      timed_op<_topology> op(period, published, topo, target, t0, hit);
+
+      const qap_prob::soleval_t se = ts.run(starts[r], op);
+#pragma omp critical
+      {
+	if (se.second < best.second) best = se;
+      }
+    }
+    gettimeofday(&t1,0);
+
+    if (hit>=0) {
+      sum_ttt += hit;
+      ++hits;
+    }
+    sum_t += dt(t1,t0);
+    sum_eval += best.second;
+  }
+
+  std::cout << topo.name() << "\t";
+  if (hits>0) std::cout << sum_ttt/hits;
+  else std::cout << "-";
+  std::cout << "\t" << hits << "/" << starts.size() 
+	    << "\t" << sum_t/starts.size() << "\t" << sum_eval/starts.size() << std::endl;
+}
+
+
+int _main(int argc, char* argv[])
+{
+  qap_prob::instance().load(argv[1]);
+  const qap_prob::eval_t target = argc>2 ? atof(argv[2]) : 0;
+  const int threads = argc>3 ? atoi(argv[3]) : omp_get_max_threads();
+  const unsigned runs = argc>4 ? atoi(argv[4]) : 10;
+  const unsigned period = argc>5 ? atoi(argv[5]) : 50;
+  const unsigned n_iter = argc>6 ? atoi(argv[6]) : 5000;
+
+  omp_set_num_threads(threads);
+
+  std::vector<qap_prob::soleval_t> starts(runs);
+  qap_gen gen;
+  for (unsigned i=0; i<runs; ++i)
+    starts[i] = gen();
+
+  std::cout << "topology\ttime_to_target\thits\ttime\teval" << std::endl;
+  bench(ring_topology(), starts, target, period, n_iter);
+  bench(torus_topology(), starts, target, period, n_iter);
+  bench(hypercube_topology(), starts, target, period, n_iter);
+  bench(random_regular_topology(), starts, target, period, n_iter);
+  bench(gossip_topology(), starts, target, period, n_iter);
+
+  return 0;
+}
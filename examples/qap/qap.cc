@@ -21,6 +21,7 @@
 #include <iostream>
 #include <algorithm>
 #include "qap_prob.hh"
+#include "qap_oper.hh"
 #include "meta_algos.hh"
 #include "meta_main.hh"
 #include "meta_permutation.hh"
@@ -28,86 +29,6 @@
 
 using namespace metl;
 
-// define a move for the quadratic assignment problem
-struct move: public permutation_move<qap_prob> {
-  move(unsigned i=0, unsigned j=1) : 
-    permutation_move<qap_prob>(i,j) {}
-  // constructor from an iterator of the gain structure.
-  move(const utrig_matrix<qap_prob::eval_t>::iterator& it) :
-    permutation_move<qap_prob>(it.get_i(),it.get_j()) {}
-
-  // move cost evaluation function
-  inline qap_prob::eval_t cost(const qap_prob::sol_t &p) const {
-    return qap_prob::instance().compute_delta(p, get_i(), get_j());
-  }
-};  
-
-typedef permutation_neighborhood<qap_prob, move> neighborhood;
-typedef permutation_generator<qap_prob> qap_gen;
-
-
-// define a tabu list for QAP
-struct tabu_list: public abstract_tabu_list<qap_prob, move> {
-  tabu_list(): t_list(qap_prob::instance().size(), qap_prob::instance().size()) {}
-
-  inline bool is_tabu(const move& m, const qap_prob::sol_t& sol, unsigned current_cycle) const {
-    if (t_list(m.get_i(), sol[m.get_j()]) < current_cycle ||
-	t_list(m.get_j(), sol[m.get_i()]) < current_cycle) 
-      return false;
-    return true;
-  }
-
-  inline void make_tabu(const move& m, const qap_prob::sol_t& sol, unsigned cycle, unsigned tenur_in, unsigned tenur_out) {
-    t_list(m.get_i(), sol[m.get_j()]) = cycle+tenur_in;
-    t_list(m.get_j(), sol[m.get_i()]) = cycle+tenur_out;
-  }
-
-
-private:
-  Matrix<unsigned> t_list;
-};
-
-
-// define a gain structure for QAP
-struct gain : public abstract_gain<qap_prob, move, utrig_matrix<qap_prob::eval_t>::iterator> {
-
-  gain()
-    : G(qap_prob::instance().size(), qap_prob::instance().size()) {}
-  
-  void update_after(const move& m, const qap_prob::sol_t& p) {
-    // move m was selected and has been performed on solution p.
-    // update the gain structure
-    const unsigned r = m.get_i();
-    const unsigned s = m.get_j();
-
-    // update matrix of the move costs
-    const unsigned size=qap_prob::instance().size();
-    const qap_prob& instance = qap_prob::instance();
-
-    for (unsigned i = 0; i < size-1; ++i) {
-      for (unsigned j = i+1; j < size; ++j)
-	if (i != r && i != s && j != r && j != s)
-	    G(i,j) += instance.compute_delta_part(p,i,j,r,s);
-	else
-	    G(i,j) = move(i,j).cost(p);
-    }
-  }
-
-  inline iterator begin() {
-    return G.begin();
-  }
-
-  inline iterator end() {
-    return G.end();
-  }
-
-private:
-  utrig_matrix<qap_prob::eval_t> G;
-};
-
-
-
-
 struct mutation : abstract_mutation<qap_prob> {
   void operator()(qap_prob::sol_t& s) const {
     unsigned size = qap_prob::instance().size();
@@ -156,6 +77,19 @@ int _main(int argc, char* argv[])
   
   tabu_ns_omp qap_ts(qap_prob::instance().size(), 40000);
   test_generator(&qap_ts);
+
+  // the gain structure is updated and searched by the threads
+  tabu_gain_ns_omp<qap_prob, move, gain, tabu_list, qap_gen> 
+    qap_ts_g(qap_prob::instance().size(), 40000);
+  test_generator(&qap_ts_g);
+
+  // inside the cooperation, each search evaluates with a pool of one
+  // thread
+  omp_blackboard_coop<tabu_ns_omp_pool<qap_prob, move, neighborhood, tabu_list, qap_gen> > 
+    qap_ts_pool(200, RANDOM, 20);
+  qap_ts_pool.set_tenur(qap_prob::instance().size());
+  qap_ts_pool.set_n_iter(40000);
+  test_generator(&qap_ts_pool);
 #endif
 #else
 #ifndef USE_MPI
@@ -195,8 +129,23 @@ int _main(int argc, char* argv[])
   ts_p.set_tenur(rng(0.5*n, 1.5*n));
   ts_p.set_n_iter(40000);
   test_generator(&ts_p);  
+
+#if MPI_VERSION >= 3
+  mpi_rma_blackboard_coop<tabu_qap> ts_rma(200, RANDOM_BETTER, 20);
+  ts_rma.set_tenur(rng(0.5*n, 1.5*n));
+  ts_rma.set_n_iter(40000);
+  test_generator(&ts_rma);  
+#endif
   
   
+  // the threads of each process share a pool, the processes exchange
+  // every 10 local exchanges
+  hybrid_coop<tabu_qap> ts_h(200, 10, RANDOM, 20);
+  ts_h.set_tenur(rng(0.5*n, 1.5*n));
+  ts_h.set_n_iter(40000);
+  test_generator(&ts_h);  
+
+
   mpi_ring_coop<evo2_type> evo_p(10);
   evo_p.set_generations(2000);
   evo_p.set_popsize(40);
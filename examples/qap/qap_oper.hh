@@ -0,0 +1,143 @@
+#ifndef QAP_OPER_HH
+#define QAP_OPER_HH
+
+// move, tabu list and gain structure for the quadratic assignment
+// problem. Shared by qap.cc and bench_ns.cc
+
+#include "qap_prob.hh"
+#include "meta_base.hh"
+#include "meta_utility.hh"
+#include "meta_permutation.hh"
+#include "wire.hh"
+
+using namespace metl;
+
+// define a move for the quadratic assignment problem
+struct move: public permutation_move<qap_prob> {
+  move(unsigned i=0, unsigned j=1) : 
+    permutation_move<qap_prob>(i,j) {}
+  // constructor from an iterator of the gain structure.
+  move(const utrig_matrix<qap_prob::eval_t>::iterator& it) :
+    permutation_move<qap_prob>(it.get_i(),it.get_j()) {}
+
+  // move cost evaluation function
+  inline qap_prob::eval_t cost(const qap_prob::sol_t &p) const {
+    return qap_prob::instance().compute_delta(p, get_i(), get_j());
+  }
+
+  // the elements of the solution the cost depends on (see move_cache.hh)
+  void reads(std::vector<unsigned>& elements) const {
+    qap_prob::instance().delta_reads(get_i(), get_j(), elements);
+  }
+
+  // permutation_neighborhood sends the moves (i,j) in blocks with the
+  // same i. They are evaluated together by compute_delta_row.
+  enum { batch_size = 32 };
+
+  static void cost_batch(const qap_prob::sol_t &p, const move* moves, 
+			 qap_prob::eval_t* costs, unsigned n) {
+    unsigned js[batch_size];
+    unsigned k=0;
+    while (k<n) {
+      const unsigned i = moves[k].get_i();
+      unsigned m=0;
+      while (k+m<n && m<batch_size && moves[k+m].get_i()==i) {
+	js[m] = moves[k+m].get_j();
+	++m;
+      }
+      qap_prob::instance().compute_delta_row(p, i, js, costs+k, m);
+      k+=m;
+    }
+  }
+};  
+
+typedef permutation_neighborhood<qap_prob, move> neighborhood;
+typedef permutation_generator<qap_prob> qap_gen;
+
+
+// define a tabu list for QAP
+struct tabu_list: public abstract_tabu_list<qap_prob, move> {
+  tabu_list(): t_list(qap_prob::instance().size(), qap_prob::instance().size()) {}
+
+  inline bool is_tabu(const move& m, const qap_prob::sol_t& sol, unsigned current_cycle) const {
+    if (t_list(m.get_i(), sol[m.get_j()]) < current_cycle ||
+	t_list(m.get_j(), sol[m.get_i()]) < current_cycle) 
+      return false;
+    return true;
+  }
+
+  inline void make_tabu(const move& m, const qap_prob::sol_t& sol, unsigned cycle, unsigned tenur_in, unsigned tenur_out) {
+    t_list(m.get_i(), sol[m.get_j()]) = cycle+tenur_in;
+    t_list(m.get_j(), sol[m.get_i()]) = cycle+tenur_out;
+  }
+
+
+private:
+  Matrix<unsigned> t_list;
+
+  friend struct metl::wire<tabu_list>;
+};
+
+
+// the tabu list in the checkpoints
+namespace metl {
+template <>
+struct wire<tabu_list> {
+  static void encode(const tabu_list& x, std::vector<char>& buf) {
+    wire<Matrix<unsigned> >::encode(x.t_list, buf);
+  }
+
+  static const char* decode(const char* p, tabu_list& x) {
+    return wire<Matrix<unsigned> >::decode(p, x.t_list);
+  }
+};
+}
+
+
+// define a gain structure for QAP. Row i holds the moves (i,j), j>i.
+struct gain : public separable_gain<qap_prob, move, utrig_matrix<qap_prob::eval_t>::iterator> {
+
+  gain()
+    : G(qap_prob::instance().size(), qap_prob::instance().size()) {}
+  
+  void update_row_after(const move& m, const qap_prob::sol_t& p, unsigned i) {
+    // move m was selected and has been performed on solution p.
+    // update row i of the gain structure
+    const unsigned r = m.get_i();
+    const unsigned s = m.get_j();
+
+    // update matrix of the move costs
+    const unsigned size=qap_prob::instance().size();
+    const qap_prob& instance = qap_prob::instance();
+
+    for (unsigned j = i+1; j < size; ++j)
+      if (i != r && i != s && j != r && j != s)
+	G(i,j) += instance.compute_delta_part(p,i,j,r,s);
+      else
+	G(i,j) = move(i,j).cost(p);
+  }
+
+  unsigned rows() const { return qap_prob::instance().size()-1; }
+
+  inline iterator row_begin(unsigned i) {
+    return iterator(G, i, i+1);
+  }
+
+  inline iterator row_end(unsigned i) {
+    return iterator(G, i+1, i+2);
+  }
+
+  inline iterator begin() {
+    return G.begin();
+  }
+
+  inline iterator end() {
+    return G.end();
+  }
+
+private:
+  utrig_matrix<qap_prob::eval_t> G;
+};
+
+
+#endif
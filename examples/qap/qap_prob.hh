@@ -26,6 +26,41 @@ struct qap_prob: public metl::abstract_problem<std::vector<int>, long> {
     return(d);
   }
 
+  // compute_delta for the moves (i,js[m]), m<n. The loop on k is the
+  // outer one so a(k,i), a(i,k), b(p[k],p[i]) and b(p[i],p[k]) are
+  // read once for all the moves and the inner loop can be vectorized.
+  inline void compute_delta_row(const std::vector<int>& p, unsigned i, 
+				const unsigned* js, long* d, unsigned n) const {
+    for (unsigned m=0; m<n; ++m) {
+      const unsigned j=js[m];
+      d[m] = 
+	(a(i,i)-a(j,j))*
+	(b(p[j],p[j])-b(p[i],p[i])) +
+	(a(i,j)-a(j,i))*
+	(b(p[j],p[i])-b(p[i],p[j]))
+	// the loop below also adds k==j, remove it
+	- (a(j,i)-a(j,j))*
+	(b(p[j],p[j])-b(p[j],p[i])) 
+	- (a(i,j)-a(j,j))*
+	(b(p[j],p[j])-b(p[i],p[j]));
+    }
+
+    for (unsigned k = 0; k < _size; ++k) {
+      if (k==i) continue;
+      const long aki = a(k,i);
+      const long aik = a(i,k);
+      const long bki = b(p[k],p[i]);
+      const long bik = b(p[i],p[k]);
+      for (unsigned m=0; m<n; ++m) {
+	const unsigned j=js[m];
+	d[m] += (aki - a(k,j))*
+	  (b(p[k],p[j]) - bki) +
+	  (aik - a(j,k))*
+	  (b(p[j],p[k]) - bik);
+      }
+    }
+  }
+
   inline long compute_delta_part(const std::vector<int>& p, unsigned i, unsigned j, unsigned r, unsigned s) const
   {
     return (a(r,i)-a(r,j)+
@@ -38,6 +73,17 @@ struct qap_prob: public metl::abstract_problem<std::vector<int>, long> {
        b(p[j],p[r])-b(p[i],p[r]));
   }
 
+  // the elements of p read by compute_delta(p,i,j). The term of k is
+  // 0 when the flows of i and j with k are the same, so sparse flow
+  // matrices give few elements.
+  void delta_reads(unsigned i, unsigned j, std::vector<unsigned>& elements) const {
+    elements.push_back(i);
+    elements.push_back(j);
+    for (unsigned k = 0; k < _size; ++k)
+      if (k!=i && k!=j && (a(k,i)!=a(k,j) || a(i,k)!=a(j,k)))
+	elements.push_back(k);
+  }
+
   inline unsigned size() const { return _size; }
 
   inline static qap_prob& instance() { 
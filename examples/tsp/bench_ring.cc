@@ -0,0 +1,82 @@
+// Synchronous against asynchronous ring cooperation (omp_ring_coop and
+// omp_ring_coop::set_async) of 3-opt simulated annealings: wall time
+// and quality of the final solution.
+//
+// usage: bench_ring tsplib_file [threads] [runs] [exchange_period]
+//
+// Both rings start each run from the same solution.
+
+#include <iostream>
+#include <cstdlib>
+
+#include "tsp_prob.hh"
+#include "meta_algos.hh"
+#include "meta_main.hh"
+#include "../test_functions.h"
+
+#include "tsp_oper.hh"
+
+using namespace metl;
+
+
+template <class _ring>
+double time_ring(_ring& ring, const tsp_prob::soleval_t& start, tsp_prob::eval_t& result) 
+{
+  timeval t0, t1;
+  gettimeofday(&t0,0);
+  result = ring(start).second;
+  gettimeofday(&t1,0);
+  return dt(t1,t0);
+}
+
+
+int _main(int argc, char* argv[])
+{
+  tsp_prob::instance().load(argv[1]);
+  const int threads = argc>2 ? atoi(argv[2]) : omp_get_max_threads();
+  const unsigned runs = argc>3 ? atoi(argv[3]) : 5;
+  const unsigned period = argc>4 ? atoi(argv[4]) : 10;
+
+  typedef descent_fm<tsp_prob, three_opt_move, three_opt_nh, tsp_gen> descent3opt;
+  typedef simulated_annealing<tsp_prob, three_opt_move, three_opt_nh, descent3opt, metropolis<tsp_prob, three_opt_move>, special_cooler<three_opt_nh> > ls3opt;
+
+  omp_set_num_threads(threads);
+
+  omp_ring_coop<ls3opt> sync_ring(period);
+  omp_ring_coop<ls3opt> async_ring(period);
+  async_ring.set_async(true);
+
+  omp_ring_coop<ls3opt>* rings[2] = {&sync_ring, &async_ring};
+  for (unsigned i=0; i<2; ++i) {
+    rings[i]->set_init_temp(100);
+    rings[i]->set_final_temp(0.5);
+    rings[i]->cooling_scheme().set_step_length(50);
+    rings[i]->cooling_scheme().set_cooling_factor(0.05);
+  }
+
+  tsp_gen gen;
+  double sum_t[2] = {0, 0};
+  double sum_eval[2] = {0, 0};
+
+  std::cout << "run\tsync_time\tsync_eval\tasync_time\tasync_eval" << std::endl;
+  for (unsigned r=0; r<runs; ++r) {
+    const tsp_prob::soleval_t start = gen();
+
+    std::cout << r;
+    for (unsigned i=0; i<2; ++i) {
+      tsp_prob::eval_t result;
+      const double t = time_ring(*rings[i], start, result);
+      sum_t[i] += t;
+      sum_eval[i] += result;
+      std::cout << "\t" << t << "\t" << result;
+    }
+    std::cout << std::endl;
+  }
+
+  std::cout << "mean";
+  for (unsigned i=0; i<2; ++i)
+    std::cout << "\t" << sum_t[i]/runs << "\t" << sum_eval[i]/runs;
+  std::cout << std::endl;
+
+  return 0;
+}
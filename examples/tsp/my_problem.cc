@@ -13,57 +13,12 @@
 #include "two_opt.hh"
 #include "three_opt.hh"
 #include "tsp_eax.hh"
+#include "tsp_oper.hh"
 
 //void boost::throw_exception(std::exception const &) {}
 
 using namespace metl;
 
-struct tsp_double_bridge : public abstract_mutation<tsp_prob>
-{
-  void operator()(tour& s) const {
-    s.double_bridge();
-  }
-};
-
-
-
-template <class neighborhood>
-struct special_cooler: public cooling_geometric_steps<neighborhood> {
-  special_cooler(double* temp)
-    : cooling_geometric_steps<neighborhood>(temp)
-  { }
-
-  bool operator()() {
-    if (cooling_geometric_steps<neighborhood>::operator()()) {
-      // also reset dl_bits when temperature is modified
-      this->nh->reset_dl_bits();
-      return true;
-    }
-    return false;
-  }
-};
-
-
-
-struct tsp_gen: public generator<tsp_prob> {
-  tsp_prob::soleval_t operator()() {
-    std::vector<unsigned> tmp_sol;
-    const unsigned size = tsp_prob::instance().size();
-    tmp_sol.reserve(size+1);
-    unsigned i=0;
-
-    for (i=0; i<size; i++)
-      tmp_sol.push_back(i);
-    
-    //shuffle the cities in a random order
-    random_shuffle(tmp_sol.begin(), tmp_sol.end(), rng);
-
-    return std::make_pair(tour(tmp_sol),tsp_prob::instance().evaluation(tmp_sol));
-  }
-};
-
-
-
 // ********** Main program *****************
 int _main(int argc, char* argv[]) {
   tsp_prob::instance().load(argv[1]);
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <assert.h>
 #include <iostream>
+#include "wire.hh"
 
 class tsp_prob;
 
@@ -37,6 +38,13 @@ struct tour {
   
   unsigned operator[](unsigned i) const { return A[i]; }
 
+  // put city c at position i. The tour is valid again once every
+  // moved city has been put at its new position.
+  void set(unsigned i, unsigned c) {
+    A[i] = c;
+    B[c] = i;
+  }
+
   tour& operator=(const std::vector<unsigned>& _A) {
     A = _A;
     updateB();
@@ -68,4 +76,56 @@ private:
   void updateB();
 };
 
+
+// only the cities are sent, the positions are computed on receipt
+namespace metl {
+template <>
+struct wire<tour> {
+  static void encode(const tour& x, std::vector<char>& buf) {
+    wire<std::vector<unsigned> >::encode(x.get_tour(), buf);
+  }
+
+  static const char* decode(const char* p, tour& x) {
+    std::vector<unsigned> A;
+    p = wire<std::vector<unsigned> >::decode(p, A);
+    x = A;
+    return p;
+  }
+};
+
+// the changed positions of the cities, only their positions are updated
+template <>
+struct wire_delta<tour> {
+  static void encode(const tour& ref, const tour& x, std::vector<char>& buf) {
+    wire_delta<std::vector<unsigned> >::encode(ref.get_tour(), x.get_tour(), buf);
+  }
+
+  static const char* decode(const char* p, tour& x) {
+    unsigned k;
+    p = wire<unsigned>::decode(p, k);
+    if (k==wire_delta_full)
+      return wire<tour>::decode(p, x);
+
+    for (unsigned j=0; j<k; ++j) {
+      unsigned i, c;
+      p = wire<unsigned>::decode(p, i);
+      p = wire<unsigned>::decode(p, c);
+      x.set(i, c);
+    }
+    return p;
+  }
+
+  static void assign(tour& x, const tour& y) {
+    if (x.size()!=y.size()) {
+      x = y;
+      return;
+    }
+    for (unsigned i=0; i<y.size(); ++i) {
+      if (x[i]!=y[i]) 
+	x.set(i, y[i]);
+    }
+  }
+};
+}
+
 #endif
@@ -9,7 +9,7 @@
 #include <assert.h>
 
 
-#include "sprng_rand.hh"
+#include "metl_rng.hh"
 
 #include "tsp_eax.hh"
 
@@ -0,0 +1,63 @@
+#ifndef TSP_OPER_HH
+#define TSP_OPER_HH
+
+// mutation, cooling scheme and generator for the traveling salesman
+// problem. Shared by my_problem.cc and bench_ring.cc
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+#include "tsp_prob.hh"
+#include "meta_algos.hh"
+
+#include "two_opt.hh"
+#include "three_opt.hh"
+
+using namespace metl;
+
+struct tsp_double_bridge : public abstract_mutation<tsp_prob>
+{
+  void operator()(tour& s) const {
+    s.double_bridge();
+  }
+};
+
+
+
+template <class neighborhood>
+struct special_cooler: public cooling_geometric_steps<neighborhood> {
+  special_cooler(double* temp)
+    : cooling_geometric_steps<neighborhood>(temp)
+  { }
+
+  bool operator()() {
+    if (cooling_geometric_steps<neighborhood>::operator()()) {
+      // also reset dl_bits when temperature is modified
+      this->nh->reset_dl_bits();
+      return true;
+    }
+    return false;
+  }
+};
+
+
+
+struct tsp_gen: public generator<tsp_prob> {
+  tsp_prob::soleval_t operator()() {
+    std::vector<unsigned> tmp_sol;
+    const unsigned size = tsp_prob::instance().size();
+    tmp_sol.reserve(size+1);
+    unsigned i=0;
+
+    for (i=0; i<size; i++)
+      tmp_sol.push_back(i);
+    
+    //shuffle the cities in a random order
+    random_shuffle(tmp_sol.begin(), tmp_sol.end(), rng);
+
+    return std::make_pair(tour(tmp_sol),tsp_prob::instance().evaluation(tmp_sol));
+  }
+};
+
+#endif
@@ -27,11 +27,16 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <vector>
+
 namespace metl {
 
 template<class prob_t, class _move, class _iterator_type>
 struct abstract_gain {
   typedef _iterator_type iterator;
+  typedef _move move_t;
+  typedef typename prob_t::sol_t sol_t;
+  typedef typename prob_t::eval_t eval_t;
 
   virtual ~abstract_gain() {}
 
@@ -51,6 +56,63 @@ struct abstract_gain {
 
   virtual iterator begin() =0;
   virtual iterator end() =0;
+
+  // the gains that know which entries their updates write return true
+  // and call changed() for each of them, so the structures kept next to
+  // the gain (sorted_gain) only look at those entries
+  virtual bool logs_changes() const { return false; }
+
+  // positions in the order of the iterator of the entries written
+  // since the last clear_changes(), maybe more than once
+  const std::vector<unsigned>& changes() const { return _changes; }
+  void clear_changes() { _changes.clear(); }
+
+  // the positions are only kept when somebody reads them
+  void log_changes(bool on) { 
+    _logging = on; 
+    _changes.clear();
+  }
+
+protected:
+  abstract_gain() : _logging(false), _changes() {}
+
+  inline void changed(unsigned k) {
+    if (_logging) _changes.push_back(k);
+  }
+
+private:
+  bool _logging;
+  std::vector<unsigned> _changes;
+};
+
+
+// a gain structure made of rows that can be updated and searched
+// independently, by different threads (see ns_gain_omp). A row update
+// may only write in its row. update_before and update_after update the
+// rows one after the other.
+template<class prob_t, class _move, class _iterator_type>
+struct separable_gain : public abstract_gain<prob_t, _move, _iterator_type> {
+  typedef abstract_gain<prob_t, _move, _iterator_type> base;
+  typedef typename base::iterator iterator;
+
+  virtual unsigned rows() const =0;
+  virtual iterator row_begin(unsigned r) =0;
+  virtual iterator row_end(unsigned r) =0;
+
+  virtual void update_row_before(const _move& m, const typename prob_t::sol_t& sol, unsigned r) {}
+  virtual void update_row_after(const _move& m, const typename prob_t::sol_t& sol, unsigned r) {}
+
+  virtual void update_before(const _move& m, const typename prob_t::sol_t& sol) {
+    const unsigned n = rows();
+    for (unsigned r=0; r<n; ++r)
+      update_row_before(m, sol, r);
+  }
+
+  virtual void update_after(const _move& m, const typename prob_t::sol_t& sol) {
+    const unsigned n = rows();
+    for (unsigned r=0; r<n; ++r)
+      update_row_after(m, sol, r);
+  }
 };
 }
 
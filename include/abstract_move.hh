@@ -34,8 +34,23 @@ namespace metl {
 
 template <class prob_t>
 struct abstract_move {
+  // number of moves a neighborhood should put in a block before
+  // asking for their costs. 1 disables the blocks. Moves that define
+  // their own cost_batch() usually want a larger value.
+  enum { batch_size = 1 };
+
   virtual ~abstract_move() {}; 
 
+  // compute the costs of n moves. Users can hide this function with a
+  // version that evaluates the moves together, for example to share
+  // work between moves or to let the compiler vectorize the loops.
+  template <class _move>
+  static void cost_batch(const typename prob_t::sol_t &sol, const _move* moves, 
+			 typename prob_t::eval_t* costs, unsigned n) {
+    for (unsigned k=0; k<n; ++k)
+      costs[k] = moves[k].internal_cost(sol);
+  }
+
   // this is the function that is used internally. In debug mode, It
   // checks that the returned value of user defined cost function is
   // consistant with the evaluation cost.
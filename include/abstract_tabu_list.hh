@@ -29,6 +29,8 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace metl {
 
+// the tabu list is saved in the checkpoints with metl::wire, the
+// problem specializes it for its list (see wire.hh)
 template<class prob_t, class _move>
 struct abstract_tabu_list {
   virtual ~abstract_tabu_list() {}
@@ -27,6 +27,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
 #include "metl_def.hh"
 
 #ifdef USE_MPI
@@ -41,8 +42,10 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "move_reduction.hh"
 
 #include "neighborhood_oper.hh"
+#include "move_cache.hh"
 #include "meta_gen.hh"
 #include "dummy_oper.hh"
+#include "budget.hh"
 
 namespace metl {
 
@@ -57,19 +60,72 @@ struct keep_best : public move_reduction<prob_t, _move> {
       s(sol)
   {  }
 
+  typedef thread_reduction<keep_best, _move, typename prob_t::eval_t> thread_op;
+
   inline bool operator()(const _move m) {
-    const typename prob_t::eval_t e=m.internal_cost(s);
-    operator()(m,e);
-    return false;
+    return select(base::thread_slot(), m);
   }
 
   inline bool operator()(const _move m, const typename prob_t::eval_t& e) {
-    if (e<0 && e<base::thread_cost()) { 
-      base::update_thread_move_and_cost(m,e);
+    return select(base::thread_slot(), m, e);
+  }
+
+  inline bool select(typename base::slot_t& best, const _move& m) const {
+    return select(best, m, m.internal_cost(s));
+  }
+
+  inline bool select(typename base::slot_t& best, const _move& m, const typename prob_t::eval_t& e) const {
+    if (e<0 && e<best.cost) { 
+      best.m = m;
+      best.cost = e;
     }
     return false;
   }
 
+  // a move must cost less than this to be selected
+  inline typename prob_t::eval_t threshold(const typename base::slot_t& best) const {
+    return std::min(best.threshold(), typename prob_t::eval_t(0));
+  }
+
+private:
+  const typename prob_t::sol_t& s;
+};
+
+
+// keep the k best improving moves, see k_best_reduction
+template<class prob_t, class _move, class _conflicts>
+struct keep_k_best : public k_best_reduction<prob_t, _move, _conflicts> {
+  typedef k_best_reduction<prob_t, _move, _conflicts> base;
+
+  keep_k_best(const typename prob_t::sol_t& sol, unsigned k)
+    : base(k),
+      s(sol)
+  {  }
+
+  typedef thread_reduction<keep_k_best, _move, typename prob_t::eval_t> thread_op;
+
+  inline bool operator()(const _move m) {
+    return select(base::thread_slot(), m);
+  }
+
+  inline bool operator()(const _move m, const typename prob_t::eval_t& e) {
+    return select(base::thread_slot(), m, e);
+  }
+
+  inline bool select(typename base::slot_t& best, const _move& m) const {
+    return select(best, m, m.internal_cost(s));
+  }
+
+  inline bool select(typename base::slot_t& best, const _move& m, const typename prob_t::eval_t& e) const {
+    if (e<0 && e<best.threshold()) 
+      best.insert(m, e);
+    return false;
+  }
+
+  inline typename prob_t::eval_t threshold(const typename base::slot_t& best) const {
+    return std::min(best.threshold(), typename prob_t::eval_t(0));
+  }
+
 private:
   const typename prob_t::sol_t& s;
 };
@@ -83,11 +139,13 @@ struct first_improve {
   first_improve(typename prob_t::sol_t &sol, typename prob_t::eval_t &sol_eval)
     : s(sol),
       ev(sol_eval),
-      _found(false)
+      _found(false),
+      _evaluated(0)
   { }
 
   inline bool operator()(const _move m)
   {
+    ++_evaluated;
     const typename prob_t::eval_t e=m.internal_cost(s);
 
     if (e<0) {
@@ -98,15 +156,23 @@ struct first_improve {
     }
     return false;
   }
-  
+
   bool found() const { return _found; }
   void reset() { _found=false; }
 
+  // charge the moves seen since the last call to the budget
+  void commit() {
+    budget& b = budget::instance();
+    if (b.counts_moves()) b.add_moves(_evaluated);
+    _evaluated = 0;
+  }
+
 private:
   typename prob_t::sol_t& s; 
   typename prob_t::eval_t& ev;
   bool _found;  // remember if we have found an improving move during
 		// this neighborhood evaluation
+  unsigned long _evaluated;
 };
 
 
@@ -124,11 +190,13 @@ public:
 
     _neighborhood n;
     first_improve<prob_t, _move> fm(se.first, se.second);
+    search_stop stop;
 
     do {
       fm.reset();
       n(fm, se.first);
-    } while (fm.found());
+      fm.commit();
+    } while (fm.found() && !stop());
 
     CHECK_EVAL(se);
     return se;
@@ -140,6 +208,193 @@ public:
 
 
 
+// which move a parallel first improvement descent applies when several
+// threads find an improving move
+enum FirstImproveMode {
+  LOWEST_INDEX,   // the first one in the scan order, same result for any number of threads
+  FASTEST         // the first one found
+};
+
+
+// this is shared by the threads of a parallel first improvement
+// scan. Each thread scans partial neighborhoods through a thread_op. The
+// first improving move found is published, and the other threads stop
+// as soon as they see that their part of the scan cannot win anymore.
+template <class prob_t, class _move>
+class first_improve_ns {
+public:
+  class thread_op;
+
+  first_improve_ns(const typename prob_t::sol_t &sol, FirstImproveMode mode)
+    : s(sol),
+      _mode(mode),
+      _found_k(std::numeric_limits<unsigned>::max()),
+      _m(),
+      _e(0)
+  { }
+
+  void reset() { 
+    _found_k = std::numeric_limits<unsigned>::max();
+#pragma omp flush
+  }
+
+  bool found() const { return _found_k != std::numeric_limits<unsigned>::max(); }
+  const _move& move() const { return _m; }
+  typename prob_t::eval_t cost() const { return _e; }
+
+  // position in the scan order of the partial neighborhood where the
+  // move was found
+  unsigned position() const { return _found_k; }
+
+  // true if the scan of the partial neighborhood at position k in the
+  // scan order can stop
+  inline bool stopped(unsigned k) const {
+    return _mode==LOWEST_INDEX ? _found_k < k : found();
+  }
+
+private:
+  friend class thread_op;
+
+  void publish(unsigned k, const _move& m, const typename prob_t::eval_t e) {
+#pragma omp critical (METL_FIRST_IMPROVE_NS)
+    {
+      if (_mode==LOWEST_INDEX ? k < _found_k : !found()) {
+	_m = m;
+	_e = e;
+#pragma omp flush
+	_found_k = k;
+      }
+    }
+#pragma omp flush
+  }
+
+  const typename prob_t::sol_t &s;
+  const FirstImproveMode _mode;
+  volatile unsigned _found_k;
+  _move _m;
+  typename prob_t::eval_t _e;
+};
+
+
+// a thread's view of first_improve_ns. Call start() before each partial
+// neighborhood.
+template <class prob_t, class _move>
+class first_improve_ns<prob_t, _move>::thread_op {
+public:
+  thread_op(first_improve_ns& shared) : sh(shared), _k(0), _done(false), _evaluated(0) {}
+
+  void start(unsigned k) { 
+    _k = k; 
+    _done = false;
+  }
+
+  inline bool operator()(const _move m) {
+    if (stopped()) return false;
+
+    ++_evaluated;
+    const typename prob_t::eval_t e=m.internal_cost(sh.s);
+    if (e<0) {
+      sh.publish(_k, m, e);
+      _done=true;   // ignore the other moves of this partial neighborhood
+    }
+    return false;  // the move is applied by the algorithm after the scan
+  }
+
+  // a block of moves with their costs (see move_block.hh)
+  enum { batch_costs = 1 };
+  inline bool stopped() { return _done || (_done=sh.stopped(_k)); }
+
+  inline unsigned block(const _move* moves, const typename prob_t::eval_t* costs, unsigned n) {
+    _evaluated += n;
+    for (unsigned i=0; i<n; ++i) {
+      if (costs[i]<0) {
+	sh.publish(_k, moves[i], costs[i]);
+	_done=true;
+	break;
+      }
+    }
+    return n;
+  }
+
+  // charge the moves seen by this thread to the budget
+  void commit() {
+    budget& b = budget::instance();
+    if (b.counts_moves()) b.add_moves(_evaluated);
+    _evaluated = 0;
+  }
+
+private:
+  first_improve_ns& sh;
+  unsigned _k;
+  bool _done;
+  unsigned long _evaluated;
+};
+
+
+// descent that applies first improving move, the neighborhood is
+// scanned in parallel with OpenMP. _neighborhood must be a
+// separable_neighborhood. A scan starts where the previous move was
+// found, like the sequential version that keeps going after a move.
+template<class prob_t, class _move, class _neighborhood, class generator_type=no_generator<prob_t> >
+struct descent_fm_ns_omp : public meta_gen<prob_t, generator_type> {
+public:
+  using meta_gen<prob_t, generator_type>::operator();
+  using meta_gen<prob_t, generator_type>::generator;
+
+  descent_fm_ns_omp(FirstImproveMode mode=LOWEST_INDEX)
+    : _mode(mode)
+  {}
+
+  void set_mode(FirstImproveMode mode) { _mode = mode; }
+
+
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se_in) {
+    typename prob_t::soleval_t se(se_in);
+    CHECK_EVAL(se);
+
+    _neighborhood n;
+    first_improve_ns<prob_t, _move> fm(se.first, _mode);
+    const unsigned size = n.size();
+    unsigned start = 0;
+    search_stop stop;
+
+    while (!stop()) {
+      fm.reset();
+
+#pragma omp parallel
+      {
+	typename first_improve_ns<prob_t, _move>::thread_op top(fm);
+	const unsigned rank = omp_get_thread_num();
+	const unsigned threads = omp_get_num_threads();
+
+	// threads take the positions of the scan order in turn so they
+	// all move through the first positions together
+	for (unsigned k=rank; k<size && !fm.stopped(k); k+=threads) {
+	  top.start(k);
+	  n.iteration(top, se.first, (start+k)%size);
+	}
+	top.commit();
+      }
+
+      if (!fm.found()) break;
+
+      fm.move()(se.first);    // apply improving move
+      se.second += fm.cost();
+      start = (start+fm.position())%size;
+    }
+
+    CHECK_EVAL(se);
+    return se;
+  }
+
+  const std::string name() const { return "Parallel descent that accept first improving move using OpenMP"; }
+
+private:
+  FirstImproveMode _mode;
+};
+
+
+
 // generic DESCENT
 template<class prob_t, class _move, class _neighborhood, class generator_type=no_generator<prob_t> >
 class descent_base: public meta_gen<prob_t, generator_type> {
@@ -168,7 +423,11 @@ protected:
     _move best_move;
 
     keep_best<prob_t, _move> keeper(se.first, best_move, mpi);
-    while (1) {
+    search_stop stop;
+
+    // another thread or process may have reached the target, or the
+    // budget is spent
+    while (!stop()) {
       nh_eval(keeper, se.first);
       keeper.reduce();
 
@@ -235,6 +494,185 @@ public:
 
 
 
+// same as descent_ns_omp, but the threads are started once for the
+// whole descent instead of once per neighborhood evaluation.
+template<class prob_t, class _move, class _neighborhood, class generator_type=no_generator<prob_t> >
+class descent_ns_omp_pool : public descent_base<prob_t, _move, _neighborhood, generator_type> {
+  typedef descent_base<prob_t, _move, _neighborhood, generator_type> base;
+public:
+  using base::operator();
+  using base::generator;
+
+
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se) {
+    _neighborhood n;
+    ns_nh_omp_pool<_neighborhood, _move, typename prob_t::sol_t> nh_eval(n);
+    dummy_op dummy;
+
+    if (nh_eval.size()==1)
+      return base::operator()(se, nh_eval, dummy);
+
+    typename prob_t::soleval_t se_out;
+#pragma omp parallel num_threads(nh_eval.size())
+    {
+      if (omp_get_thread_num()==0) {
+	se_out = base::operator()(se, nh_eval, dummy);
+	nh_eval.release();
+      } else {
+	nh_eval.serve();
+      }
+    }
+    return se_out;
+  }
+  const std::string name() const { return "Parallel descent based on neighborhood seperation using a pool of OpenMP threads"; }
+};
+
+
+
+
+// this version keeps the costs of the moves from one iteration to the
+// next (see move_cache.hh)
+template<class prob_t, class _move, class _neighborhood, class generator_type=no_generator<prob_t> >
+class descent_cache : public descent_base<prob_t, _move, _neighborhood, generator_type> {
+  typedef descent_base<prob_t, _move, _neighborhood, generator_type> base;
+
+public:
+  using base::operator();
+  using base::generator;
+
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se) {
+    _neighborhood n;
+    cached_nh_eval<_neighborhood, _move, prob_t> nh_eval(n);
+
+    return base::operator()(se, nh_eval, nh_eval);
+  }
+  const std::string name() const { return "Descent using a cache of the move costs"; }
+};
+
+
+template<class prob_t, class _move, class _neighborhood, class generator_type=no_generator<prob_t> >
+class descent_cache_ns_omp : public descent_base<prob_t, _move, _neighborhood, generator_type> {
+  typedef descent_base<prob_t, _move, _neighborhood, generator_type> base;
+
+public:
+  using base::operator();
+  using base::generator;
+
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se) {
+    _neighborhood n;
+    cached_nh_omp<_neighborhood, _move, prob_t> nh_eval(n);
+
+    return base::operator()(se, nh_eval, nh_eval);
+  }
+  const std::string name() const { return "Parallel descent using a cache of the move costs and OpenMP"; }
+};
+
+
+
+
+// DESCENT that applies several moves per neighborhood evaluation. The k
+// best improving moves are kept and the ones that do not conflict
+// (see k_best_reduction) are applied in increasing order of cost.
+// Compatible moves can still interact through the cost function, so
+// every move but the first is evaluated again before it is applied and
+// skipped if it no longer improves the solution.
+template<class prob_t, class _move, class _neighborhood, class _conflicts, class generator_type=no_generator<prob_t> >
+class descent_multi_base: public meta_gen<prob_t, generator_type> {
+
+#ifdef XLC_WORKAROUND
+public:
+#else
+protected:
+#endif
+
+  using meta_gen<prob_t, generator_type>::operator();
+  using meta_gen<prob_t, generator_type>::generator;
+
+
+  descent_multi_base(unsigned k) : _k(k) { }
+
+
+  template <class _nh_eval>
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se_in, _nh_eval& nh_eval) const {
+    typename prob_t::soleval_t se(se_in);
+    CHECK_EVAL(se);
+
+    keep_k_best<prob_t, _move, _conflicts> keeper(se.first, _k);
+    search_stop stop;
+
+    while (!stop()) {
+      nh_eval(keeper, se.first);
+      keeper.reduce();
+
+      if (keeper.cost()>=0) break;
+
+      const std::vector<typename keep_k_best<prob_t, _move, _conflicts>::entry_t>& sel = keeper.selected();
+      for (unsigned i=0; i<sel.size(); ++i) {
+	const typename prob_t::eval_t e = i==0 ? sel[i].cost : sel[i].m.internal_cost(se.first);
+	if (e>=0) continue;
+
+	sel[i].m(se.first);           // applique le mouvement
+	se.second+=e;
+      }
+
+      keeper.reset();
+    }
+    CHECK_EVAL(se);
+    return se;
+  }
+
+public:
+  // maximum number of moves applied per neighborhood evaluation
+  void set_k(unsigned k) { _k = k; }
+  unsigned get_k() const { return _k; }
+
+private:
+  unsigned _k;
+};
+
+
+template<class prob_t, class _move, class _neighborhood, class _conflicts, class generator_type=no_generator<prob_t> >
+class descent_multi : public descent_multi_base<prob_t, _move, _neighborhood, _conflicts, generator_type> {
+  typedef descent_multi_base<prob_t, _move, _neighborhood, _conflicts, generator_type> base;
+
+public:
+  using base::operator();
+  using base::generator;
+
+  descent_multi(unsigned k=16) : base(k) {}
+
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se) {
+    _neighborhood n;
+    basic_nh_eval<_neighborhood, _move, typename prob_t::sol_t> nh_eval(n);
+
+    return base::operator()(se, nh_eval);
+  }
+  const std::string name() const { return "Descent that applies several compatible moves per neighborhood evaluation"; }
+};
+
+
+template<class prob_t, class _move, class _neighborhood, class _conflicts, class generator_type=no_generator<prob_t> >
+class descent_multi_ns_omp : public descent_multi_base<prob_t, _move, _neighborhood, _conflicts, generator_type> {
+  typedef descent_multi_base<prob_t, _move, _neighborhood, _conflicts, generator_type> base;
+
+public:
+  using base::operator();
+  using base::generator;
+
+  descent_multi_ns_omp(unsigned k=16) : base(k) {}
+
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se) {
+    _neighborhood n;
+    ns_nh_omp<_neighborhood, _move, typename prob_t::sol_t> nh_eval(n);
+
+    return base::operator()(se, nh_eval);
+  }
+  const std::string name() const { return "Parallel descent that applies several compatible moves per neighborhood evaluation using OpenMP"; }
+};
+
+
+
+
 #ifdef USE_MPI
 template<class prob_t, class _move, class _neighborhood, class generator_type=no_generator<prob_t> >
 class descent_ns_mpi : public descent_base<prob_t, _move, _neighborhood, generator_type> {
@@ -282,6 +720,29 @@ public:
   const std::string name() const { return "Descent using a gain structure"; }
 };
 
+
+// same, the gain structure must be a separable_gain. Its rows are
+// searched and updated by OpenMP threads.
+template<class prob_t, class _move, class _gain_struct_t, class generator_type=no_generator<prob_t> >
+class descent_gain_ns_omp : public descent_base<prob_t, _move, dummy_neighborhood<prob_t>, generator_type> {
+  typedef descent_base<prob_t, _move, dummy_neighborhood<prob_t>, generator_type> base;
+
+public:
+  using base::operator();
+  using base::generator;
+
+
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se) {
+    
+    _gain_struct_t _gain;
+    _gain.init(se.first);
+    ns_gain_omp<_gain_struct_t, _move, typename prob_t::sol_t> nh_eval(_gain);
+    
+    return base::operator()(se, nh_eval, nh_eval);
+  }
+  const std::string name() const { return "Parallel descent using a gain structure and OpenMP"; }
+};
+
 }
 
 #endif
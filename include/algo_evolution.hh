@@ -31,6 +31,8 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <utility>
 
 #include "dummy_oper.hh"
+#include "budget.hh"
+#include "checkpoint.hh"
 #include "evolution_oper.hh"
 #include "generator.hh"
 
@@ -128,22 +130,45 @@ protected:
     // sort initial pop
     std::sort(pop.begin(), pop.end(), individus_compare<typename prob_t::soleval_t>);
     
-    for (gen=0; 
-	 gen<_generations && pop.front().second > instance.optimum();    // FIXME: mthode de terminaison parallle.
+    termination& term = termination::instance();
+    search_stop stop;
+    budget& b = budget::instance();
+    const typename prob_t::eval_t optimum = termination_target<prob_t>();
+
+    // the initial population
+    if (b.counts_evaluations()) b.add_evaluations(_popsize-1);
+
+    unsigned first_gen = 0;
+    // a generation can be long, the clock is read at each one
+    search_checkpoint ckpt("evolution", 1);
+    if (const char* p = ckpt.restore()) {
+      p = wire<unsigned>::decode(p, first_gen);
+      p = wire<unsigned>::decode(p, wp_i);
+      wire<std::vector<typename prob_t::soleval_t> >::decode(p, pop);
+    }
+
+    // stops at the target, when another thread or process reached it,
+    // or when the budget is spent
+    for (gen=first_gen; 
+	 gen<_generations && !(pop.front().second <= optimum && term.raise()) && !stop();
 	 ++gen) {
       
 
-      for (n=0; n<signed_nchilds; ++n) {
+      for (n=0; n<signed_nchilds && !stop(); ++n) {
 	typename std::vector<typename prob_t::soleval_t>::const_iterator p1, p2;
 	
 	_selection(pop, p1, p2);
 	x_over(*p1, *p2, childrens[n]);
 	
+	// the crossover evaluates the child
+	unsigned long evaluations = 1;
 	if (mutation.rate()>0 && rng()<mutation.rate()) {
 	  mutation(childrens[n].first);
 	  // re-evaluate after mutation
 	  childrens[n].second = instance.evaluation(childrens[n].first);
+	  ++evaluations;
 	}
+	if (b.counts_evaluations()) b.add_evaluations(evaluations);
 	
 	childrens[n]=ls(childrens[n]);
 	CHECK_EVAL(childrens[n]);
@@ -164,6 +189,14 @@ protected:
 	      std::cout << "\tgeneration:" << gen << "  best eval: " << pop.front().second << std::endl;
 	    }
       }
+
+      if (ckpt.due()) {
+	std::vector<char>& buf = ckpt.begin();
+	wire<unsigned>::encode(gen+1, buf);
+	wire<unsigned>::encode(wp_i, buf);
+	wire<std::vector<typename prob_t::soleval_t> >::encode(pop, buf);
+	ckpt.commit();
+      }
     }
 
     const typename prob_t::soleval_t& x = pop.front();
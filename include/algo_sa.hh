@@ -30,12 +30,14 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 // generic simulated annealing
 
 
-#include "sprng_rand.hh"
+#include "metl_rng.hh"
 #include <math.h>
 
 #include "exchange_oper.hh"
 #include "meta_gen.hh"
 #include "dummy_oper.hh"
+#include "budget.hh"
+#include "checkpoint.hh"
 #include "sa_oper.hh"
 
 namespace metl {
@@ -127,19 +129,47 @@ protected:
 
     _neighborhood n;
     cooler.set_neighborhood(n);
-    const typename prob_t::eval_t optimum = prob_t::instance().optimum();
+    termination& term = termination::instance();
+    search_stop stop;
+    budget& b = budget::instance();
+    const typename prob_t::eval_t optimum = termination_target<prob_t>();
     accept.reset_counters();
 
+    // kept when the search has to go on after reaching the target
+    typename prob_t::soleval_t at_target;
+    bool reached = false;
+
+    search_checkpoint ckpt("sa");
+    if (const char* p = ckpt.restore()) {
+      p = wire<double>::decode(p, current_temp);
+      p = cooler.decode(p);
+      unsigned rejects;
+      p = wire<unsigned>::decode(p, rejects);
+      accept.set_rejects(rejects);
+      wire<typename prob_t::soleval_t>::decode(p, se);
+    }
+
 #ifdef SA_TRACE
     typename prob_t::eval_t best=se.second;
     unsigned it=0;
 #endif 
 
     while (current_temp>final_T && 
-	   se.second > optimum && 
 	   accept.get_rejects()<max_rejects) {
 
+      if (se.second <= optimum) {
+	if (term.raise()) break;
+	if (!reached) {
+	  at_target = se;
+	  reached = true;
+	}
+      }
+      // another thread or process reached the target, or the budget
+      // is spent
+      if (stop()) break;
+
       n(accept, se.first);
+      if (b.counts_moves()) b.add_moves(accept.take_evaluated());
       cooler();
 
       // exchange solution. This is for the Multiple Markov chains 
@@ -159,7 +189,18 @@ protected:
       ++it;
 #endif
 
+      if (ckpt.due()) {
+	std::vector<char>& buf = ckpt.begin();
+	wire<double>::encode(current_temp, buf);
+	cooler.encode(buf);
+	wire<unsigned>::encode(accept.get_rejects(), buf);
+	wire<typename prob_t::soleval_t>::encode(se, buf);
+	ckpt.commit();
+      }
     }
+    if (reached && at_target.second < se.second)
+      se = at_target;
+
     CHECK_EVAL(se);
     return se;
   }
@@ -30,7 +30,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
 // generic tabu engine
-// variants are: tabu, tabu_gain, tabu_ns_omp, tabu_ns_mpi
+// variants are: tabu, tabu_gain, tabu_gain_ns_omp, tabu_cache, tabu_ns_omp, tabu_ns_mpi
 
 
 #include <limits>
@@ -38,9 +38,12 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <algorithm>
 
 #include "neighborhood_oper.hh"
+#include "move_cache.hh"
 #include "move_reduction.hh"
 #include "meta_gen.hh"
 #include "dummy_oper.hh"
+#include "budget.hh"
+#include "checkpoint.hh"
 #include <time.h>
 
 namespace metl {
@@ -68,22 +71,37 @@ public:
   {}
 
 
+  typedef thread_reduction<tabu_kernel, _move, typename prob_t::eval_t> thread_op;
+
   // tabu kernel. Called from the neighborhood evaluation (defined by user)
   // compute move evaluation
   inline bool operator()(const _move m) {
-    operator()(m,m.internal_cost(s));
-    return false;  // always return false because move not directly applied
+    return select(base::thread_slot(), m);
   }
 
   // evaluation is available. This is called either from previous version or
   //    from tabu_gain because the gain structure already has the cost of the
   //    move pre-computed
   inline bool operator()(const _move m, const typename prob_t::eval_t& e) {
-    if ((e<base::thread_cost()) && (!_tl.is_tabu(m, s, _cycle) || (e+ce < be))) {
-      base::update_thread_move_and_cost(m,e);
+    return select(base::thread_slot(), m, e);
+  }
+
+  inline bool select(typename base::slot_t& best, const _move& m) const {
+    return select(best, m, m.internal_cost(s));
+  }
+
+  inline bool select(typename base::slot_t& best, const _move& m, const typename prob_t::eval_t& e) const {
+    if ((e<best.cost) && (!_tl.is_tabu(m, s, _cycle) || (e+ce < be))) {
+      best.m = m;
+      best.cost = e;
     }
     return false;  // always return false because move not directly applied
   }
+
+  // a move must cost less than this to be selected
+  inline typename prob_t::eval_t threshold(const typename base::slot_t& best) const {
+    return best.threshold();
+  }
   
 private:
   const typename prob_t::sol_t& s;
@@ -176,7 +194,20 @@ protected:
 
     tabu_k_t tabu_k(se.first, next_move, se.second, best.second, tl, cycle, mpi);
 
-    const typename prob_t::eval_t optimum = prob_t::instance().optimum();
+    termination& term = termination::instance();
+    search_stop stop;
+    const typename prob_t::eval_t optimum = termination_target<prob_t>();
+
+    search_checkpoint ckpt("tabu");
+    ckpt.set_mpi(mpi);
+    if (const char* p = ckpt.restore()) {
+      p = wire<unsigned>::decode(p, cycle);
+      p = wire<typename prob_t::soleval_t>::decode(p, se);
+      p = wire<typename prob_t::soleval_t>::decode(p, best);
+      p = wire<_tabu_list>::decode(p, tl);
+      restore_rng(p, srng);
+      gain.init(se.first);
+    }
 
     while(cycle<=_n_iter) {
       nh_eval(tabu_k, se.first);
@@ -215,15 +246,29 @@ protected:
 #endif
 	  cycle << " xxxx "<< se.second << std::endl;
 #endif
-	if (se.second <= optimum) break;
+	if (se.second <= optimum && term.raise()) break;
       }
 
       if (periodic_exchange(se)) {
 	gain.init(se.first);
       }
 
+      // another thread or process reached the target, or the budget
+      // is spent
+      if (stop()) break;
+
       tabu_k.reset();
       ++cycle;
+
+      if (ckpt.due()) {
+	std::vector<char>& buf = ckpt.begin();
+	wire<unsigned>::encode(cycle, buf);
+	wire<typename prob_t::soleval_t>::encode(se, buf);
+	wire<typename prob_t::soleval_t>::encode(best, buf);
+	wire<_tabu_list>::encode(tl, buf);
+	save_rng(srng, buf);
+	ckpt.commit();
+      }
     }
 
     if ((se_in.second > best.second) || (srng()>return_current)) {
@@ -241,6 +286,16 @@ protected:
   unsigned _n_iter;
 private:
   float return_current;
+
+  // the sync_rng of the parallel versions is saved with the search,
+  // the stream of rng already is by search_checkpoint
+  static void save_rng(const sync_rng& srng, std::vector<char>& buf) { srng.pack(buf); }
+  template <class RNG>
+  static void save_rng(const RNG&, std::vector<char>&) {}
+
+  static void restore_rng(const char* p, sync_rng& srng) { srng.unpack(p); }
+  template <class RNG>
+  static void restore_rng(const char*, RNG&) {}
 };
 
 
@@ -281,6 +336,80 @@ protected:
 };
 
 
+// this version keeps the costs of the moves from one iteration to the
+// next (see move_cache.hh)
+template<class prob_t, 
+	 class _move, 
+	 class _neighborhood, 
+	 class _tabu_list, 
+	 class generator_type=no_generator<prob_t> >
+class tabu_cache : public tabu_base<prob_t, _move, _neighborhood, _tabu_list, generator_type> {
+
+  typedef tabu_base<prob_t, _move, _neighborhood, _tabu_list, generator_type> base;
+
+public:
+  using base::operator();
+  using base::generator;
+
+
+  tabu_cache(unsigned tabu_tenur=8, unsigned n_iter=1000)
+    : base(tabu_tenur, n_iter)
+  {}
+  const std::string name() const { return "Tabu Search using a cache of the move costs"; }
+
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se) {
+    dummy_op dummy;
+    return operator()(se, dummy);
+  }
+
+protected:
+  template <class PE> 
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se, PE& periodic_exchange) {
+    _neighborhood n;
+    cached_nh_eval<_neighborhood, _move, prob_t> nh_eval(n);
+
+    return base::operator()(se, nh_eval, nh_eval, periodic_exchange, rng);
+  }
+};
+
+
+// same, the moves are evaluated by OpenMP threads
+template<class prob_t, 
+	 class _move, 
+	 class _neighborhood, 
+	 class _tabu_list, 
+	 class generator_type=no_generator<prob_t> >
+class tabu_cache_ns_omp : public tabu_base<prob_t, _move, _neighborhood, _tabu_list, generator_type> {
+
+  typedef tabu_base<prob_t, _move, _neighborhood, _tabu_list, generator_type> base;
+
+public:
+  using base::operator();
+  using base::generator;
+
+
+  tabu_cache_ns_omp(unsigned tabu_tenur=8, unsigned n_iter=1000)
+    : base(tabu_tenur, n_iter)
+  {}
+  const std::string name() const { return "Parallel tabu search using a cache of the move costs and OpenMP"; }
+
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se) {
+    dummy_op dummy;
+    return operator()(se, dummy);
+  }
+
+protected:
+  template <class PE> 
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se, PE& periodic_exchange) {
+    _neighborhood n;
+    cached_nh_omp<_neighborhood, _move, prob_t> nh_eval(n);
+    sync_rng srng(time(0));
+
+    return base::operator()(se, nh_eval, nh_eval, periodic_exchange, srng);
+  }
+};
+
+
 // this version uses OpenMP for parallel neighborhood evaluation
 template<class prob_t, 
 	 class _move, 
@@ -322,6 +451,63 @@ protected:
 
 
 
+// same as tabu_ns_omp, but the threads are started once for the whole
+// search instead of once per iteration.
+template<class prob_t, 
+	 class _move, 
+	 class _neighborhood, 
+	 class _tabu_list, 
+	 class generator_type=no_generator<prob_t> >
+class tabu_ns_omp_pool : public tabu_base<prob_t, _move,_neighborhood, _tabu_list, generator_type> {
+
+  typedef tabu_base<prob_t, _move, _neighborhood, _tabu_list, generator_type> base;
+
+public:
+   using base::operator();
+   using base::generator;
+
+
+  tabu_ns_omp_pool(unsigned tabu_tenur=8, unsigned n_iter=1000)
+    : base(tabu_tenur, n_iter)
+  {}
+
+  const std::string name() const { return "Parallel tabu search based on neighborhood separation using a pool of OpenMP threads"; }
+
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se) {
+    dummy_op dummy;
+    return operator()(se, dummy);
+  }
+
+protected:
+  template<class PE>
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se, PE& periodic_exchange) {
+    _neighborhood n;
+    ns_nh_omp_pool<_neighborhood, _move, typename prob_t::sol_t> nh_eval(n);
+    dummy_op dummy;
+    sync_rng srng(time(0));
+
+    if (nh_eval.size()==1)
+      return base::operator()(se, nh_eval, dummy, periodic_exchange, srng);
+
+    typename prob_t::soleval_t se_out;
+#pragma omp parallel num_threads(nh_eval.size())
+    {
+      // only thread 0 runs the search, so periodic_exchange is never
+      // called by the workers
+      if (omp_get_thread_num()==0) {
+	se_out = base::operator()(se, nh_eval, dummy, periodic_exchange, srng);
+	nh_eval.release();
+      } else {
+	nh_eval.serve();
+      }
+    }
+    return se_out;
+  }
+};
+
+
+
+
 #ifdef USE_MPI
 
 // this version use MPI to seperate neighborhood evaluation
@@ -414,6 +600,51 @@ protected:
 };
 
 
+
+// same as tabu_gain, the gain structure must be a separable_gain. Its
+// rows are searched and updated by OpenMP threads.
+template<class prob_t,
+	 class _move, 
+	 class _gain_struct_t, 
+	 class _tabu_list, 
+	 class generator_type=no_generator<prob_t> >
+class tabu_gain_ns_omp : public tabu_base<prob_t, _move, dummy_neighborhood<prob_t>, _tabu_list,generator_type> {
+  typedef tabu_base<prob_t, _move, dummy_neighborhood<prob_t>, _tabu_list, generator_type> base;
+
+public:
+   using base::operator();
+   using base::generator;
+
+
+  tabu_gain_ns_omp(unsigned tabu_tenur=8, unsigned n_iter=1000)
+    : base(tabu_tenur, n_iter)
+  {}
+
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se) {
+    dummy_op dummy;
+    return operator()(se, dummy);
+  }
+  
+  const std::string name() const { return "Parallel tabu search using a gain structure and OpenMP"; }  
+
+#ifdef XLC_WORKAROUND
+public:
+#else
+protected:
+#endif
+
+  template <class PE>
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se, PE& periodic_exchange) {
+
+    _gain_struct_t _gain;
+    _gain.init(se.first);
+    ns_gain_omp<_gain_struct_t, _move, typename prob_t::sol_t> nh_eval(_gain);
+    sync_rng srng(time(0));
+
+    return base::operator()(se, nh_eval, nh_eval, periodic_exchange, srng);
+  }
+};
+
 }
 
 #endif
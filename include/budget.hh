@@ -0,0 +1,184 @@
+#ifndef BUDGET_HH
+#define BUDGET_HH
+
+/*
+metl: A generic framework for sequential and parallel metaheuristics
+Copyright (c) 2005-2015, Sylvain Ouellet
+
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+
+*/
+
+#include <ctime>
+#include "metl_def.hh"
+#include "termination.hh"
+
+#ifdef _OPENMP
+#ifndef INCLUDED_OMP_H   
+#define INCLUDED_OMP_H   
+#include <omp.h>         
+#endif                   
+#else                    
+#include "omp_stub.h"    
+#endif
+
+namespace metl {
+
+// the budget of the searches of a process: a wall-clock time, a CPU
+// time, a number of move evaluations and a number of full
+// evaluations, counted from start(). meta_main starts it with the
+// program, so a wall-clock budget matches the time limit of the
+// job. A limit of 0 is no limit.
+//
+// The threads share the budget. The processes each have theirs, the
+// first one that spends it stops the others through the termination
+// token (see search_stop).
+class budget {
+public:
+  inline static budget& instance() { 
+    static budget _instance;
+    return _instance;
+  }
+
+  // the clocks are read every check_period polls of a search
+  static const unsigned check_period = 16;
+
+  void set_wall_time(double seconds) { _max_wall = seconds; }
+  void set_cpu_time(double seconds) { _max_cpu = seconds; }
+  void set_move_evaluations(unsigned long n) { _max_moves = n; }
+  void set_evaluations(unsigned long n) { _max_evals = n; }
+
+  void clear() {
+    _max_wall = 0;
+    _max_cpu = 0;
+    _max_moves = 0;
+    _max_evals = 0;
+  }
+
+  // the clocks and the counters start from now
+  void start() {
+    _wall0 = omp_get_wtime();
+    _cpu0 = std::clock();
+    _moves = 0;
+    _evals = 0;
+  }
+
+  bool limited() const { return _max_wall>0 || _max_cpu>0 || _max_moves>0 || _max_evals>0; }
+
+  // the evaluations are only counted when they are limited
+  bool counts_moves() const { return _max_moves>0; }
+  bool counts_evaluations() const { return _max_evals>0; }
+
+  void add_moves(unsigned long n) {
+#pragma omp atomic
+    _moves += n;
+  }
+
+  void add_evaluations(unsigned long n) {
+#pragma omp atomic
+    _evals += n;
+  }
+
+  double wall_time() const { return omp_get_wtime()-_wall0; }
+  // of all the threads of the process
+  double cpu_time() const { return double(std::clock()-_cpu0)/CLOCKS_PER_SEC; }
+
+  unsigned long moves() const {
+    unsigned long n;
+#pragma omp atomic read
+    n = _moves;
+    return n;
+  }
+
+  unsigned long evaluations() const {
+    unsigned long n;
+#pragma omp atomic read
+    n = _evals;
+    return n;
+  }
+
+  // true when a limit is reached. It reads the clocks, the searches
+  // call it through search_stop.
+  bool exhausted() const {
+    return (_max_moves>0 && moves()>=_max_moves) ||
+      (_max_evals>0 && evaluations()>=_max_evals) ||
+      (_max_wall>0 && wall_time()>=_max_wall) ||
+      (_max_cpu>0 && cpu_time()>=_max_cpu);
+  }
+
+private:
+  budget()
+    : _max_wall(0), _max_cpu(0), _max_moves(0), _max_evals(0),
+      _wall0(0), _cpu0(0), _moves(0), _evals(0)
+  { start(); }
+
+  budget(const budget&);
+  budget& operator=(const budget&);
+
+  double _max_wall, _max_cpu;
+  unsigned long _max_moves, _max_evals;
+
+  double _wall0;
+  std::clock_t _cpu0;
+  unsigned long _moves;   // only accessed with omp atomic
+  unsigned long _evals;
+};
+
+
+// what a search polls once per iteration: the termination token and
+// the budget. Keep one per search, it only looks at the budget every
+// budget::check_period polls. When the budget is spent, the search
+// raises the token, so a synchronous cooperation stops at its next
+// exchange like for a target.
+class search_stop {
+public:
+  search_stop()
+    : term(termination::instance()),
+      b(budget::instance()),
+      limited(b.limited()),
+      polls(0),
+      spent(false),
+      done(false)
+  {}
+
+  // true when the search must stop
+  inline bool operator()() {
+    if (done || term.stopped()) return true;
+    if (!limited || spent || ++polls < budget::check_period) return false;
+    polls = 0;
+    if (!b.exhausted()) return false;
+    spent = true;
+    done = term.raise();
+    return done;
+  }
+
+private:
+  termination& term;
+  budget& b;
+  const bool limited;
+  unsigned polls;
+  bool spent;
+  bool done;
+};
+
+}
+
+#endif
@@ -0,0 +1,432 @@
+#ifndef CHECKPOINT_HH
+#define CHECKPOINT_HH
+
+/*
+metl: A generic framework for sequential and parallel metaheuristics
+Copyright (c) 2005-2015, Sylvain Ouellet
+
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+
+*/
+
+// periodic checkpoints of the searches, and resume.
+//
+//   metl::checkpoint::instance().enable("job", 600);        // every 10 minutes
+//   metl::checkpoint::instance().enable("job", 600, true);  // resume from the files of job first
+//
+// tabu_base, simulated_annealing and evolution save their state (the
+// current and best solutions, the iteration, the temperature, the
+// population, the random stream of the thread) in
+// job.<rank>.<thread>.<search>. The cooperations with a pool of
+// solutions save it in job.<rank>.pool. With resume, the searches
+// started afterwards continue from these files, each file is used
+// once. Only the outermost search of a thread is saved, the local
+// search of evolution for instance restarts with its caller.
+//
+// A search writes its state in a buffer and gives it to a thread that
+// writes the files, it does not wait for the disk. A file is written
+// under another name and then renamed, a crash during the write leaves
+// the previous checkpoint.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <sstream>
+#include <iostream>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "metl_def.hh"
+#include "wire.hh"
+#include "termination.hh"
+#include "metl_rng.hh"
+
+#ifdef USE_MPI
+#ifdef HAVE_MPIPP_H     
+#include <mpi++.h>
+#else
+#include <mpi.h>
+#endif  // HAVE_MPIPP_H
+#endif  // USE_MPI
+
+#ifdef _OPENMP
+#ifndef INCLUDED_OMP_H   
+#define INCLUDED_OMP_H   
+#include <omp.h>         
+#endif                   
+#else                    
+#include "omp_stub.h"    
+#endif
+
+namespace metl {
+
+// writes files in a thread of its own. A file that is queued again
+// before it is written is only written once, with the latest content.
+class checkpoint_writer {
+public:
+  checkpoint_writer()
+    : _pending(), _started(false), _quit(false), _busy(false)
+  {
+    pthread_mutex_init(&_lock, 0);
+    pthread_cond_init(&_work, 0);
+    pthread_cond_init(&_idle, 0);
+  }
+
+  ~checkpoint_writer() {
+    stop();
+    pthread_cond_destroy(&_idle);
+    pthread_cond_destroy(&_work);
+    pthread_mutex_destroy(&_lock);
+  }
+
+  // queue buf for file. buf is swapped with an old buffer, its capacity
+  // is reused.
+  void post(const std::string& file, std::vector<char>& buf) {
+    pthread_mutex_lock(&_lock);
+    if (!_started)
+      _started = pthread_create(&_thread, 0, run, this)==0;
+    if (!_started) {
+      // no thread, the file is written now
+      pthread_mutex_unlock(&_lock);
+      write(file, buf);
+      return;
+    }
+    _pending[file].swap(buf);
+    pthread_cond_signal(&_work);
+    pthread_mutex_unlock(&_lock);
+    buf.clear();
+  }
+
+  // wait until the files queued are written
+  void flush() {
+    pthread_mutex_lock(&_lock);
+    while (!_pending.empty() || _busy)
+      pthread_cond_wait(&_idle, &_lock);
+    pthread_mutex_unlock(&_lock);
+  }
+
+  // write the files queued and end the thread
+  void stop() {
+    pthread_mutex_lock(&_lock);
+    if (!_started) {
+      pthread_mutex_unlock(&_lock);
+      return;
+    }
+    _quit = true;
+    pthread_cond_signal(&_work);
+    pthread_mutex_unlock(&_lock);
+
+    pthread_join(_thread, 0);
+    _started = false;
+    _quit = false;
+  }
+
+  static bool read(const std::string& file, std::vector<char>& buf) {
+    FILE* f = fopen(file.c_str(), "rb");
+    if (f==0) return false;
+    buf.clear();
+    char tmp[4096];
+    size_t n;
+    while ((n = fread(tmp, 1, sizeof(tmp), f)) > 0)
+      buf.insert(buf.end(), tmp, tmp+n);
+    fclose(f);
+    return !buf.empty();
+  }
+
+private:
+  static void* run(void* self) {
+    static_cast<checkpoint_writer*>(self)->loop();
+    return 0;
+  }
+
+  void loop() {
+    std::string file;
+    std::vector<char> buf;
+
+    pthread_mutex_lock(&_lock);
+    while (true) {
+      while (_pending.empty() && !_quit)
+	pthread_cond_wait(&_work, &_lock);
+      if (_pending.empty()) break;   // _quit, and everything is written
+
+      file = _pending.begin()->first;
+      buf.swap(_pending.begin()->second);
+      _pending.erase(_pending.begin());
+      _busy = true;
+      pthread_mutex_unlock(&_lock);
+
+      write(file, buf);
+
+      pthread_mutex_lock(&_lock);
+      _busy = false;
+      pthread_cond_broadcast(&_idle);
+    }
+    pthread_cond_broadcast(&_idle);
+    pthread_mutex_unlock(&_lock);
+  }
+
+  static void write(const std::string& file, const std::vector<char>& buf) {
+    const std::string tmp = file + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    bool ok = f!=0;
+    if (ok && !buf.empty()) 
+      ok = fwrite(&buf[0], 1, buf.size(), f)==buf.size();
+    if (f!=0) 
+      ok = fclose(f)==0 && ok;
+    if (!ok || rename(tmp.c_str(), file.c_str())!=0)
+      std::cerr << "WARNING: could not write the checkpoint " << file << std::endl;
+  }
+
+  std::map<std::string, std::vector<char> > _pending;
+  pthread_t _thread;
+  pthread_mutex_t _lock;
+  pthread_cond_t _work;   // a file was queued, or _quit
+  pthread_cond_t _idle;   // a file was written
+  bool _started;
+  bool _quit;
+  bool _busy;
+
+  checkpoint_writer(const checkpoint_writer&);
+  checkpoint_writer& operator=(const checkpoint_writer&);
+};
+
+
+class checkpoint {
+public:
+  inline static checkpoint& instance() { 
+    static checkpoint _instance;
+    return _instance;
+  }
+
+  // polls of a search between two readings of the clock
+  static const unsigned check_period = 16;
+
+  // save every period seconds in the files named prefix.*. With
+  // resume, the searches first continue from the files of a previous
+  // run with the same prefix.
+  void enable(const std::string& prefix, double period, bool resume=false) {
+    _prefix = prefix;
+    _period = period;
+    _resume = resume;
+    _resumed.clear();
+    _enabled = true;
+  }
+
+  // the checkpoints queued are still written
+  void disable() {
+    _enabled = false;
+    _resume = false;
+  }
+
+  bool enabled() const { return _enabled; }
+  double period() const { return _period; }
+
+  // write the checkpoints queued, meta_main calls it at the end
+  void finish() { _writer.stop(); }
+
+  // the file of name for this process
+  std::string file(const std::string& name) const {
+    std::ostringstream os;
+    os << _prefix << '.' << 
+#ifdef USE_MPI
+      MPI::COMM_WORLD.Get_rank()
+#else
+      0
+#endif
+       << '.' << name;
+    return os.str();
+  }
+
+  void post(const std::string& file, std::vector<char>& buf) {
+    if (_resume) {
+      // a later search must not continue from it
+#pragma omp critical (METL_CHECKPOINT)
+      _resumed.insert(file);
+    }
+    _writer.post(file, buf);
+  }
+
+  // the content of file when resuming, the first time only
+  bool restore(const std::string& file, std::vector<char>& buf) {
+    if (!_enabled || !_resume) return false;
+    bool first;
+#pragma omp critical (METL_CHECKPOINT)
+    first = _resumed.insert(file).second;
+    return first && checkpoint_writer::read(file, buf);
+  }
+
+  // true every period seconds, last is the time of the previous
+  // checkpoint (negative before the first call)
+  bool due(double& last) const {
+    if (!_enabled) return false;
+    const double now = omp_get_wtime();
+    if (last < 0) last = now;
+    if (now-last < _period) return false;
+    last = now;
+    return true;
+  }
+
+  // the pool of the solutions shared by a cooperation (best_pool)
+  template <class _pool>
+  void save_pool(const _pool& pool) {
+    std::vector<char> buf;
+    pool.save(buf);
+    post(file("pool"), buf);
+  }
+
+  template <class _pool>
+  void restore_pool(_pool& pool) {
+    std::vector<char> buf;
+    if (restore(file("pool"), buf))
+      pool.load(&buf[0]);
+  }
+
+  // a thread enters or leaves a search, true if it is the outermost one
+  bool enter() { return ++_depth[omp_get_thread_num()] == 1; }
+  void leave() { --_depth[omp_get_thread_num()]; }
+
+private:
+  checkpoint()
+    : _prefix(), _period(0), _resume(false), _enabled(false), _resumed(), _writer()
+  {
+    for (int i=0; i<MAX_THREADS; ++i)
+      _depth[i] = 0;
+  }
+
+  checkpoint(const checkpoint&);
+  checkpoint& operator=(const checkpoint&);
+
+  std::string _prefix;
+  double _period;
+  bool _resume;
+  bool _enabled;
+  std::set<std::string> _resumed;   // the files already used
+  unsigned _depth[MAX_THREADS];     // nesting of the searches of each thread
+  checkpoint_writer _writer;
+};
+
+
+// the checkpoints of one search of the calling thread. 
+//
+//   search_checkpoint ckpt("tabu");
+//   if (const char* p = ckpt.restore()) { decode the state at p }
+//   loop {
+//     ...
+//     if (ckpt.due()) { encode the state in ckpt.begin(); ckpt.commit(); }
+//   }
+//
+// due() reads the clock every check_period calls. In a synchronous
+// cooperation, the participants must save at the same exchange or they
+// would not resume together: due() asks the termination token, and is
+// true after the exchange where they agree.
+class search_checkpoint {
+public:
+  explicit search_checkpoint(const char* search, unsigned check_period=checkpoint::check_period)
+    : ck(checkpoint::instance()),
+      term(termination::instance()),
+      outermost(ck.enter()),
+      active(outermost && ck.enabled()),
+      _file(),
+      _check_period(check_period),
+      polls(0),
+      last(-1),
+      seen(term.checkpoint_epoch()),
+      _mpi(false),
+      buf()
+  {
+    if (active) {
+      std::ostringstream os;
+      os << omp_get_thread_num() << '.' << search;
+      _file = ck.file(os.str());
+    }
+  }
+
+  ~search_checkpoint() { ck.leave(); }
+
+  // the processes run the same search (the neighborhood is evaluated
+  // with MPI), they save when the clock of rank 0 says so
+  void set_mpi(bool on) { _mpi = on; }
+
+  // the state to continue from, 0 if there is none. The random stream
+  // of the thread is already restored.
+  const char* restore() {
+    if (!active || !ck.restore(_file, buf)) return 0;
+    return rng.unpack(&buf[0]);
+  }
+
+  inline bool due() {
+    if (!active) return false;
+    if (term.collective()) {
+      const unsigned e = term.checkpoint_epoch();
+      if (e != seen) {
+	seen = e;
+	return true;
+      }
+      if (clock_due()) term.want_checkpoint();
+      return false;
+    }
+    return clock_due();
+  }
+
+  // the buffer for the state, it starts with the random stream
+  std::vector<char>& begin() {
+    buf.clear();
+    rng.pack(buf);
+    return buf;
+  }
+
+  // queue the state for writing
+  void commit() { ck.post(_file, buf); }
+
+private:
+  inline bool clock_due() {
+    if (++polls < _check_period) return false;
+    polls = 0;
+#ifdef USE_MPI
+    if (_mpi) {
+      int d = ck.due(last) ? 1 : 0;
+      MPI::COMM_WORLD.Bcast(&d, 1, MPI::INT, 0);
+      return d!=0;
+    }
+#endif
+    return ck.due(last);
+  }
+
+  checkpoint& ck;
+  termination& term;
+  const bool outermost;
+  const bool active;
+  std::string _file;
+  const unsigned _check_period;
+  unsigned polls;
+  double last;
+  unsigned seen;
+  bool _mpi;
+  std::vector<char> buf;
+
+  search_checkpoint(const search_checkpoint&);
+  search_checkpoint& operator=(const search_checkpoint&);
+};
+
+}
+
+#endif
@@ -30,6 +30,8 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <iostream>
 #include <list>
+#include <limits>
+#include <algorithm>
 
 // this is a workaround for a bug in BOOST 1_32. 
 // If your compiler does not support exceptions or you want to compile without exceptions, then define BOOST_NO_EXCEPTIONS.
@@ -40,6 +42,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #endif
 
 #include <boost/shared_array.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include "mpi_reduce_op.hh"
 
@@ -63,12 +66,16 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #endif
 
 
+#include "wire.hh"
+#include "omp_mailbox.hh"
+#include "omp_snapshot.hh"
+#include "topology.hh"
+#include "termination.hh"
+#include "checkpoint.hh"
+
 #ifdef USE_MPI
-#include <sstream>
-#include <boost/archive/binary_iarchive.hpp>
-#include <boost/archive/binary_oarchive.hpp>
-#include <boost/serialization/utility.hpp>
-#include <boost/serialization/vector.hpp>
+#include <vector>
+#include "mpi_transport.hh"
 
 #include "metl_config.hh"
 
@@ -96,62 +103,178 @@ bool individus_compare(const individu& a, const individu& b) {
 
 
 ////////////// structure qui permet the conserver les x meilleurs solutions
+//
+// The pool is an immutable snapshot: a vector, sorted by evaluation, of
+// pointers to immutable solutions, held by an omp_snapshot. Readers
+// take the current snapshot and copy the solution they pick without
+// any lock held. Writers build the new snapshot (pointer copies only)
+// in a critical section and publish it. Insertions
+// that would not enter the pool are rejected without the critical
+// section.
 template <class prob_t>
 class best_pool {
+  typedef typename prob_t::soleval_t soleval_t;
+  typedef boost::shared_ptr<const soleval_t> elite_t;
+  typedef std::vector<elite_t> snapshot_t;
 public:  
 
   best_pool(unsigned pool_size) 
     : max_size(pool_size),
-      pool()
-  {
-    //    pool.reserve(max_size+1);
-  }
+      pool(boost::shared_ptr<const snapshot_t>(new snapshot_t()))
+  {}
     
-  void insert(const typename prob_t::soleval_t& se) {
+  void insert(const soleval_t& se) {
+    if (!enters(*snapshot(), se)) return;
+
+    // the copy is made outside of the critical section
+    const elite_t e(new soleval_t(se));
+
 #pragma omp critical (OMP_BEST_POOL_ACCESS)
     {
-      if (se.second < pool.back().second || pool.size()<max_size) {
-	pool.insert(lower_bound(pool.begin(), pool.end(), se, individus_compare<typename prob_t::soleval_t>), se);
-	if (pool.size() > max_size)
-	  pool.pop_back();
+      const boost::shared_ptr<const snapshot_t> old = snapshot();
+      if (enters(*old, se)) {
+	boost::shared_ptr<snapshot_t> next(new snapshot_t());
+	next->reserve(max_size+1);
+
+	typename snapshot_t::const_iterator i = std::upper_bound(old->begin(), old->end(), e, elite_compare);
+	next->insert(next->end(), old->begin(), i);
+	next->push_back(e);
+	next->insert(next->end(), i, old->end());
+	if (next->size() > max_size)
+	  next->pop_back();
+
+	pool.store(next);
       }
     }
   }
 
-  void get_best(typename prob_t::soleval_t& se) const {
-#pragma omp critical (OMP_BEST_POOL_ACCESS)
-      {
-	se = pool.front();
-      }
+  // the get functions leave se unchanged when the pool is empty
+  void get_best(soleval_t& se) const {
+    const boost::shared_ptr<const snapshot_t> s = snapshot();
+    if (!s->empty()) 
+      se = *s->front();
   }
 
-  void get_random(typename prob_t::soleval_t& se) const
+  void get_random(soleval_t& se) const
   {
-#pragma omp critical (OMP_BEST_POOL_ACCESS)
-    {
-      typename std::list<typename prob_t::soleval_t>::const_iterator x=pool.begin();
-      advance(x,rng(pool.size()));
-      se = *x;
-    }
+    const boost::shared_ptr<const snapshot_t> s = snapshot();
+    if (!s->empty()) 
+      se = *(*s)[rng(s->size())];
   }
 
-  void get_random_better(typename prob_t::soleval_t& se) const
+  // one of the solutions better than se, the best if there is none
+  void get_random_better(soleval_t& se) const
   {
-#pragma omp critical (OMP_BEST_POOL_ACCESS)
-    {
-      typename std::list<typename prob_t::soleval_t>::const_iterator x=pool.begin();
-      typename std::list<typename prob_t::soleval_t>::const_iterator ep=lower_bound(pool.begin(), pool.end(), se, individus_compare<typename prob_t::soleval_t>);
-      advance(x,rng(distance(pool.begin(),ep)));
-      se = *x;
+    const boost::shared_ptr<const snapshot_t> s = snapshot();
+    if (s->empty()) return;
+
+    const unsigned better = std::lower_bound(s->begin(), s->end(), se.second, eval_less) - s->begin();
+    se = *(*s)[better==0 ? 0 : rng(better)];
+  }
+
+  unsigned size() const { return snapshot()->size(); }
+
+  // checkpoints (see checkpoint.hh): the solutions, best first
+  void save(std::vector<char>& buf) const {
+    const boost::shared_ptr<const snapshot_t> s = snapshot();
+    wire<unsigned>::encode(s->size(), buf);
+    for (unsigned i=0; i<s->size(); ++i)
+      wire<soleval_t>::encode(*(*s)[i], buf);
+  }
+
+  // inserts the solutions saved at p
+  void load(const char* p) {
+    unsigned n;
+    p = wire<unsigned>::decode(p, n);
+    soleval_t se;
+    for (unsigned i=0; i<n; ++i) {
+      p = wire<soleval_t>::decode(p, se);
+      insert(se);
     }
   }
 
 private:
   unsigned max_size;
-  std::list<typename prob_t::soleval_t> pool;  // FIXME: est-ce la meilleure structure
-			     // ??  Une liste est quand meme pas
-			     // si mal tant que la structure reste
-			     // petite
+  omp_snapshot<snapshot_t> pool;
+
+  boost::shared_ptr<const snapshot_t> snapshot() const {
+    return pool.load();
+  }
+
+  bool enters(const snapshot_t& s, const soleval_t& se) const {
+    return s.size() < max_size || (!s.empty() && se.second < s.back()->second);
+  }
+
+  static bool eval_less(const elite_t& a, const typename prob_t::eval_t& e) {
+    return a->second < e;
+  }
+
+  static bool elite_compare(const elite_t& a, const elite_t& b) {
+    return a->second < b->second;
+  }
+};
+
+
+// online tuning of the exchange period. Every window exchanges, the
+// period is doubled if the exchanges took more than max_comm_ratio of
+// the time or if less than 10% of the received solutions were better
+// than the current one. It is halved if at least half of them were
+// better. It stays between min_period and max_period.
+class adaptive_period {
+public:
+  adaptive_period()
+    : min_period(1), max_period(1), max_comm_ratio(0.05), window(4), _enabled(false)
+  { reset(-1); }
+
+  void enable(unsigned _min_period, unsigned _max_period, double _max_comm_ratio, unsigned _window) {
+    min_period = std::max(1u, _min_period);
+    max_period = std::max(min_period, _max_period);
+    max_comm_ratio = _max_comm_ratio;
+    window = std::max(1u, _window);
+    _enabled = true;
+    reset(-1);
+  }
+
+  bool enabled() const { return _enabled; }
+
+  // an exchange that started at t0 and ended at t1. Returns the new
+  // period at the end of a window, 0 otherwise.
+  unsigned record(double t0, double t1, bool adopted, unsigned period) {
+    if (last >= 0) search_time += t0-last;
+    comm_time += t1-t0;
+    last = t1;
+    if (adopted) ++n_adopted;
+    if (++n_exchanges < window) return 0;
+
+    const double total = comm_time+search_time;
+    const double ratio = total>0 ? comm_time/total : 0;
+    const double rate = double(n_adopted)/n_exchanges;
+    reset(t1);
+
+    if (ratio > max_comm_ratio || rate < 0.1)
+      return std::min(max_period, std::max(min_period, 2*period));
+    if (rate >= 0.5)
+      return std::max(min_period, std::min(max_period, period/2));
+    return std::min(max_period, std::max(min_period, period));
+  }
+
+private:
+  void reset(double t) {
+    n_exchanges = 0;
+    n_adopted = 0;
+    comm_time = 0;
+    search_time = 0;
+    last = t;
+  }
+
+  unsigned min_period, max_period;
+  double max_comm_ratio;
+  unsigned window;
+  bool _enabled;
+
+  unsigned n_exchanges, n_adopted;
+  double comm_time, search_time;
+  double last;         // end of the last exchange
 };
 
 
@@ -162,24 +285,50 @@ public:
   // does both send and receive
   virtual bool operator()(typename prob_t::soleval_t& se)
   {
+    // only the calls that exchange are measured
+    if (!adaptive.enabled() || cycle+1 != period) {
+      send(se);
+      return recv(se);
+    }
+
+    const typename prob_t::eval_t before = se.second;
+    const double t0 = omp_get_wtime();
     send(se);
-    return recv(se);
+    const bool modified = recv(se);
+    const double t1 = omp_get_wtime();
+
+    const unsigned p = adaptive.record(t0, t1, modified && se.second < before, period);
+    if (p) period = agree_period(p);
+    return modified;
   }
 
   virtual void send(const typename prob_t::soleval_t& se)=0;
   // returns true if sol is modified false otherwise
   virtual bool recv(typename prob_t::soleval_t& se)=0;
 
+  // adapt the period between min_period and max_period (see adaptive_period)
+  void set_adaptive(unsigned min_period, unsigned max_period, double max_comm_ratio=0.05, unsigned window=4) {
+    adaptive.enable(min_period, max_period, max_comm_ratio, window);
+  }
+
+  unsigned get_period() const { return period; }
+
 protected:
   exchange_op(unsigned exchange_period, bool _eval_recv=false)
-    : period(exchange_period), cycle(0), eval_recv(_eval_recv)
+    : period(exchange_period), cycle(0), eval_recv(_eval_recv), adaptive()
   {  }
 
   virtual ~exchange_op() {}
 
-  const unsigned period;
+  // the new period proposed by this thread or process. The operations
+  // where all the participants must exchange together make them agree
+  // on one.
+  virtual unsigned agree_period(unsigned p) { return p; }
+
+  unsigned period;
   unsigned cycle;
   bool eval_recv;
+  adaptive_period adaptive;
 };
 
 
@@ -209,7 +358,7 @@ protected:
     }
   }
 
-private:
+protected:
   const AsyncExchangePolicy policy;
 };
 
@@ -221,13 +370,18 @@ class omp_blackboard_coop_op: public blackboard_coop_op<prob_t> {
 public:
   omp_blackboard_coop_op(best_pool<prob_t>& shared_pool, unsigned exchange_period, AsyncExchangePolicy exchange_policy=RANDOM, bool _eval_recv=false)
     : base(exchange_period, exchange_policy, _eval_recv),
-      pool(shared_pool)
+      pool(shared_pool),
+      last_checkpoint(-1)
   {}
 
   void send(const typename prob_t::soleval_t& se)
   {
     if (++(this->cycle) == this->period) {
       pool.insert(se);
+
+      // the master thread saves the pool
+      if (omp_get_thread_num()==0 && checkpoint::instance().due(last_checkpoint))
+	checkpoint::instance().save_pool(pool);
     }
   }
 
@@ -246,6 +400,7 @@ public:
 
 private:
   best_pool<prob_t>& pool;
+  double last_checkpoint;
 };
 
 
@@ -261,40 +416,38 @@ public:
     : base(exchange_period, exchange_policy, _eval_recv)
   {}
 
+  // send the solutions as deltas against the previous ones
+  void set_delta(bool on) {
+    if (on) delta.enable(MPI::COMM_WORLD.Get_size());
+    else delta.disable();
+  }
 
   void tell_master(const typename prob_t::soleval_t& se) const {
     // workers must tell the master they are done
     // Once they finish, they send their best solution with it's
     // evaluation to the master
     if (MPI::COMM_WORLD.Get_rank()!=1) {
-
-      std::ostringstream send_buf(std::ios::binary);
-      // serialize solution into buffer
-      boost::archive::binary_oarchive oa(send_buf);  // create output archive
-      oa << se.first << se.second;
-      
-      // send it
-      const std::string sbuf = send_buf.str();
-      assert(sbuf.size() < max_buf_size);
-      MPI::COMM_WORLD.Send(sbuf.data(), sbuf.size(), MPI::CHAR, 1, tag_done);
+      std::vector<char> sbuf;
+      delta.encode_full(se, sbuf);
+      transport.send(sbuf, 1, tag_done);
     }
   }
 
   void master(best_pool<prob_t>& pool) {
     unsigned workers = MPI::COMM_WORLD.Get_size()-1;
-    char rbuf[max_buf_size];
     MPI::Status rstatus;
     typename prob_t::soleval_t se;
+    double last_checkpoint = -1;
 
     while(workers>0) {
-      MPI::COMM_WORLD.Recv(rbuf, max_buf_size, MPI::CHAR, MPI::ANY_SOURCE, MPI::ANY_TAG, rstatus);
+      const std::vector<char>& rbuf = transport.recv(MPI::ANY_SOURCE, MPI::ANY_TAG, rstatus);
 
       // un-serialize buffer
-      std::istringstream receive_buf(std::string(rbuf,rstatus.Get_count(MPI::CHAR)));
-      boost::archive::binary_iarchive ia(receive_buf);
-      ia >> se.first >> se.second;
+      delta.decode(rstatus.Get_source(), &rbuf[0], se);
       // add item into best_pool
       pool.insert(se);
+      if (checkpoint::instance().due(last_checkpoint))
+	checkpoint::instance().save_pool(pool);
 
 
       switch (rstatus.Get_tag()) {
@@ -307,17 +460,10 @@ public:
 	base::do_exchange(pool,se);
 	//	std::cout << " retreive: " << se.second << std::endl;
 
-	// serialize new solution
-	std::ostringstream send_buf(std::ios::binary);
-	// serialize solution into buffer
-	boost::archive::binary_oarchive oa(send_buf);  // create output archive
-	const typename prob_t::soleval_t& cse = se;
-	oa << cse.first << cse.second;
-
-	// send it
-	const std::string sbuf = send_buf.str();
-	assert(sbuf.size() < max_buf_size);
-	MPI::COMM_WORLD.Send(sbuf.data(), sbuf.size(), MPI::CHAR, rstatus.Get_source(), tag_xchange_reply);
+	// serialize new solution and send it
+	// the worker waits for it, the buffer can be reused at once
+	delta.encode(rstatus.Get_source(), se, sbuf);
+	transport.send(sbuf, rstatus.Get_source(), tag_xchange_reply);
 	break;
       }
     }
@@ -327,15 +473,8 @@ public:
   void send(const typename prob_t::soleval_t& se)
   {
     if (++(this->cycle) == this->period) {
-      std::ostringstream send_buf(std::ios::binary);
-      // serialize solution into buffer
-      boost::archive::binary_oarchive oa(send_buf);
-      oa << se.first << se.second;
-      
-      const std::string sbuf = send_buf.str(); // string is reference-counted, so copy is cheap.
-      assert(sbuf.size() < max_buf_size);
-      
-      MPI::COMM_WORLD.Isend(sbuf.data(), sbuf.size(), MPI::CHAR, 1, tag_xchange);
+      delta.encode(1, se, transport.next_buffer());
+      transport.isend(1, tag_xchange);
     }
   }
   
@@ -345,11 +484,105 @@ public:
       this->cycle=0;
 
       MPI::Status rstatus;
-      MPI::COMM_WORLD.Recv(rbuf, max_buf_size, MPI::CHAR, 1, tag_xchange_reply, rstatus);
+      const std::vector<char>& rbuf = transport.recv(1, tag_xchange_reply, rstatus);
       // unserialize solution
-      std::istringstream receive_buf(std::string(rbuf,rstatus.Get_count(MPI::CHAR)));
-      boost::archive::binary_iarchive ia(receive_buf);
-      ia >> se.first >> se.second;
+      delta.decode(1, &rbuf[0], se);
+
+      if (this->eval_recv)
+	se.second = prob_t::instance().evaluation(se.first);
+
+      CHECK_EVAL(se);
+
+      return true;
+    }
+    return false;
+  }
+
+private:
+  mpi_transport transport;
+  delta_channel<prob_t> delta;
+  std::vector<char> sbuf;
+};
+
+
+#if MPI_VERSION >= 3
+
+// a blackboard shared by all the processes through an MPI-3 window,
+// without a master. Each process holds a shard of the pool. A solution
+// goes to the shard given by its hash, where it replaces the worst one
+// if it is better. The same solution is only kept once.
+// 
+// Inserting locks the shard exclusively, fetching holds a shared lock
+// on all the shards, so a fetch sees a consistent pool. The solutions
+// must have a serialized size that does not change.
+template <class prob_t>
+class mpi_rma_blackboard_coop_op : public blackboard_coop_op<prob_t> {
+  typedef blackboard_coop_op<prob_t> base;
+  typedef wire_header<typename prob_t::eval_t> header_t;
+public:
+  mpi_rma_blackboard_coop_op(unsigned exchange_period, AsyncExchangePolicy exchange_policy=RANDOM, unsigned pool_size=10, bool _eval_recv=false)
+    : base(exchange_period, exchange_policy, _eval_recv),
+      p_size(pool_size),
+      win(MPI_WIN_NULL),
+      shard(0),
+      slots(0),
+      wire_size(0),
+      rank(0),
+      size(0),
+      headers(),
+      sbuf(),
+      payload()
+  {}
+
+  ~mpi_rma_blackboard_coop_op() {
+    if (win!=MPI_WIN_NULL && !MPI::Is_finalized()) close();
+  }
+
+  // create the window, every process must call it
+  void open(const typename prob_t::soleval_t& se) {
+    rank = MPI::COMM_WORLD.Get_rank();
+    size = MPI::COMM_WORLD.Get_size();
+    slots = (p_size+size-1)/size;
+    if (slots==0) slots=1;
+
+    wire_encode<prob_t>(se, payload);
+    wire_size = payload.size();
+
+    MPI_Win_allocate(slots*(sizeof(header_t)+wire_size), 1, MPI_INFO_NULL, MPI_COMM_WORLD, &shard, &win);
+
+    // empty slots have the worst evaluation
+    header_t h;
+    h.eval = std::numeric_limits<typename prob_t::eval_t>::max();
+    h.hash = 0;
+    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, rank, 0, win);
+    for (unsigned i=0; i<slots; ++i)
+      memcpy(shard + i*sizeof(header_t), &h, sizeof(h));
+    MPI_Win_unlock(rank, win);
+
+    headers.resize(size*slots);
+    MPI_Barrier(MPI_COMM_WORLD);
+  }
+
+  // free the window, every process must call it
+  void close() {
+    MPI_Win_free(&win);
+    win = MPI_WIN_NULL;
+    shard = 0;
+  }
+
+  void send(const typename prob_t::soleval_t& se)
+  {
+    if (++(this->cycle) == this->period) {
+      insert(se);
+    }
+  }
+
+  bool recv(typename prob_t::soleval_t& se)
+  {
+    if (this->cycle == this->period) {
+      this->cycle=0;
+
+      if (!fetch(se)) return false;
 
       if (this->eval_recv)
 	se.second = prob_t::instance().evaluation(se.first);
@@ -362,32 +595,146 @@ public:
   }
 
 private:
-  char rbuf[max_buf_size];
+  // the headers of a shard come first, then the solutions
+  MPI_Aint header_disp(unsigned i) const { return i*sizeof(header_t); }
+  MPI_Aint payload_disp(unsigned i) const { return slots*sizeof(header_t) + i*wire_size; }
+
+  void insert(const typename prob_t::soleval_t& se) {
+    wire_encode<prob_t>(se, payload);
+    if (payload.size() != wire_size) {
+      // REQUIS: serialized size must be the same !
+      std::cerr << "Serialized size must be constant" << std::endl;
+      abort();
+    }
+
+    header_t h;
+    h.eval = se.second;
+    h.hash = wire_hash(&payload[0], wire_size);
+    const unsigned target = h.hash % size;
+
+    sbuf.resize(slots*sizeof(header_t));
+    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, target, 0, win);
+    MPI_Get(&sbuf[0], sbuf.size(), MPI_BYTE, target, 0, sbuf.size(), MPI_BYTE, win);
+    MPI_Win_flush(target, win);
+
+    unsigned worst=0;
+    header_t hw, hi;
+    memcpy(&hw, &sbuf[0], sizeof(hw));
+    bool found=false;
+    for (unsigned i=0; i<slots && !found; ++i) {
+      memcpy(&hi, &sbuf[header_disp(i)], sizeof(hi));
+      found = hi.eval==h.eval && hi.hash==h.hash;
+      if (hw.better(hi)) {
+	worst = i;
+	hw = hi;
+      }
+    }
+
+    if (!found && h.better(hw)) {
+      MPI_Put(&payload[0], wire_size, MPI_BYTE, target, payload_disp(worst), wire_size, MPI_BYTE, win);
+      MPI_Put(&h, sizeof(h), MPI_BYTE, target, header_disp(worst), sizeof(h), MPI_BYTE, win);
+    }
+    MPI_Win_unlock(target, win);
+  }
+
+  // returns false if the pool is empty
+  bool fetch(typename prob_t::soleval_t& se) {
+    const unsigned n = slots*sizeof(header_t);
+    sbuf.resize(size*n);
+
+    MPI_Win_lock_all(0, win);
+    for (unsigned r=0; r<size; ++r)
+      MPI_Get(&sbuf[r*n], n, MPI_BYTE, r, 0, n, MPI_BYTE, win);
+    MPI_Win_flush_all(win);
+
+    // the solutions in the pool, sorted like in best_pool
+    unsigned used=0;
+    for (unsigned i=0; i<size*slots; ++i) {
+      header_t h;
+      memcpy(&h, &sbuf[i*sizeof(header_t)], sizeof(h));
+      if (h.eval == std::numeric_limits<typename prob_t::eval_t>::max()) continue;
+      headers[used++] = std::make_pair(h, i);
+    }
+    std::sort(headers.begin(), headers.begin()+used, header_compare);
+
+    if (used==0) {
+      MPI_Win_unlock_all(win);
+      return false;
+    }
+
+    unsigned k=0;
+    switch (this->policy) {
+    case RANDOM:
+      k = rng(used);
+      break;
+    case BEST:
+      k = 0;
+      break;
+    case RANDOM_BETTER:
+      // the solutions better than the current one, the best if there is none
+      unsigned better=0;
+      while (better<used && headers[better].first.eval < se.second) ++better;
+      if (better>0) k = rng(better);
+      break;
+    }
+
+    const unsigned owner = headers[k].second / slots;
+    const unsigned slot = headers[k].second % slots;
+    payload.resize(wire_size);
+    MPI_Get(&payload[0], wire_size, MPI_BYTE, owner, payload_disp(slot), wire_size, MPI_BYTE, win);
+    MPI_Win_unlock_all(win);
+
+    wire_decode<prob_t>(&payload[0], se);
+    return true;
+  }
+
+  static bool header_compare(const std::pair<header_t, unsigned>& a, const std::pair<header_t, unsigned>& b) {
+    return a.first.better(b.first);
+  }
+
+  unsigned p_size;
+  MPI_Win win;
+  char* shard;            // the part of the window held by this process
+  unsigned slots;         // per shard
+  unsigned wire_size;
+  unsigned rank;
+  unsigned size;
+  std::vector<std::pair<header_t, unsigned> > headers;
+  std::vector<char> sbuf, payload;
 };
 
+#endif  // MPI_VERSION >= 3
+
 
 template <class prob_t>
 struct mpi_ring_coop_op : public exchange_op<prob_t> {
   mpi_ring_coop_op(unsigned exchange_period, bool _eval_recv=false) 
     : exchange_op<prob_t>(exchange_period, _eval_recv),
       rank(MPI::COMM_WORLD.Get_rank()),
-      size(MPI::COMM_WORLD.Get_size())
+      size(MPI::COMM_WORLD.Get_size()),
+      exchange(0)
   {  }
 
+  // send the solutions as deltas against the previous ones
+  void set_delta(bool on) {
+    if (on) delta.enable(size);
+    else delta.disable();
+  }
+
   void send(const typename prob_t::soleval_t& se)
   {
     if (++(this->cycle) == this->period) {
       const unsigned send_to = rank==size-1 ? 0 : rank+1;
 
-      std::ostringstream send_buf(std::ios::binary);
-      // serialize solution into buffer
-      boost::archive::binary_oarchive oa(send_buf);
-      oa << se.first << se.second;
-      
-      const std::string sbuf = send_buf.str();
-      assert(sbuf.size() < max_buf_size);
-      
-      MPI::COMM_WORLD.Isend(sbuf.data(), sbuf.size(), MPI::CHAR, send_to, tag_xchange);
+      // the stop and checkpoint requests go around with the solutions
+      termination& term = termination::instance();
+      if (term.needs_deadline())
+	term.propose(topology_flood(ring_topology(), rank, size, exchange));
+
+      std::vector<char>& buf = transport.next_buffer();
+      delta.encode(send_to, se, buf);
+      term.append_deadlines(buf);
+      transport.isend(send_to, tag_xchange);
     }
   }
 
@@ -400,29 +747,128 @@ struct mpi_ring_coop_op : public exchange_op<prob_t> {
       const unsigned recv_from = rank==0 ? size-1 : rank-1;
       
       MPI::Status rstatus;
-      MPI::COMM_WORLD.Recv(rbuf, max_buf_size, MPI::CHAR, recv_from, tag_xchange,rstatus);
+      const std::vector<char>& rbuf = transport.recv(recv_from, tag_xchange, rstatus);
       // unserialize solution
-      std::istringstream receive_buf(std::string(rbuf,rstatus.Get_count(MPI::CHAR)));
-      boost::archive::binary_iarchive ia(receive_buf);
-      ia >> se.first >> se.second;
+      delta.decode(recv_from, &rbuf[0], se);
       
       if (this->eval_recv)
 	se.second = prob_t::instance().evaluation(se.first);
 
+      // stop together if someone reached the target
+      termination& term = termination::instance();
+      term.merge_deadlines(rbuf);
+      term.reached(exchange++);
+
       return true;  // we modified the solution
     }
     return false;
   }
 
 private:
-  char rbuf[max_buf_size];
+  // all the processes exchange together, they take the longest period
+  unsigned agree_period(unsigned p) {
+    unsigned q;
+    MPI::COMM_WORLD.Allreduce(&p, &q, 1, MPI::UNSIGNED, MPI::MAX);
+    return q;
+  }
+
+  mpi_transport transport;
+  delta_channel<prob_t> delta;
   const unsigned rank;
   const unsigned size;
-  
+  unsigned long exchange;   // number of the current exchange
 };
 
 
 
+// island model on any topology (see topology.hh): each process sends
+// its solution to its peers of the epoch and keeps the best of its
+// solution and the ones it receives.
+template <class prob_t, class _topology>
+struct mpi_topology_coop_op : public exchange_op<prob_t> {
+  mpi_topology_coop_op(unsigned exchange_period, const _topology& topology=_topology(), bool _eval_recv=false) 
+    : exchange_op<prob_t>(exchange_period, _eval_recv),
+      topo(topology),
+      rank(MPI::COMM_WORLD.Get_rank()),
+      size(MPI::COMM_WORLD.Get_size()),
+      epoch(0),
+      to(),
+      from()
+  {  }
+
+  // send the solutions as deltas against the previous ones
+  void set_delta(bool on) {
+    if (on) delta.enable(size);
+    else delta.disable();
+  }
+
+  void send(const typename prob_t::soleval_t& se)
+  {
+    if (++(this->cycle) == this->period) {
+      // the stop and checkpoint requests spread with the solutions
+      termination& term = termination::instance();
+      if (term.needs_deadline())
+	term.propose(topology_flood(topo, rank, size, epoch));
+
+      topo.peers(rank, size, epoch, to, from);
+      for (unsigned i=0; i<to.size(); ++i) {
+	std::vector<char>& buf = transport.next_buffer();
+	delta.encode(to[i], se, buf);
+	term.append_deadlines(buf);
+	transport.isend(to[i], tag_xchange);
+      }
+    }
+  }
+
+
+  bool recv(typename prob_t::soleval_t& se)
+  {
+    if (this->cycle == this->period) {
+      this->cycle=0;
+      termination& term = termination::instance();
+
+      bool modified=false;
+      for (unsigned i=0; i<from.size(); ++i) {
+	MPI::Status rstatus;
+	const std::vector<char>& rbuf = transport.recv(from[i], tag_xchange, rstatus);
+	delta.decode(from[i], &rbuf[0], tmp);
+	term.merge_deadlines(rbuf);
+
+	if (this->eval_recv)
+	  tmp.second = prob_t::instance().evaluation(tmp.first);
+
+	if (tmp.second < se.second) {
+	  se = tmp;
+	  modified = true;
+	}
+      }
+
+      // stop together if someone reached the target
+      term.reached(epoch++);
+      return modified;
+    }
+    return false;
+  }
+
+private:
+  // all the processes exchange together, they take the longest period
+  unsigned agree_period(unsigned p) {
+    unsigned q;
+    MPI::COMM_WORLD.Allreduce(&p, &q, 1, MPI::UNSIGNED, MPI::MAX);
+    return q;
+  }
+
+  mpi_transport transport;
+  delta_channel<prob_t> delta;
+  const _topology topo;
+  const unsigned rank;
+  const unsigned size;
+  unsigned long epoch;
+  std::vector<unsigned> to, from;
+  typename prob_t::soleval_t tmp;
+};
+
+
 template <class prob_t>
 struct mpi_reduce_coop_op : public exchange_op<prob_t> {
   mpi_reduce_coop_op(unsigned exchange_period, bool _eval_recv=false) 
@@ -439,38 +885,119 @@ struct mpi_reduce_coop_op : public exchange_op<prob_t> {
     if (++(this->cycle) == this->period) {
       this->cycle=0;
       
-      sol_reducter<prob_t>::Allreduce(se);
+      // the stop and checkpoint requests are reduced with the solutions
+      termination& term = termination::instance();
+      unsigned flags = term.flags();
+      sol_reducter<prob_t>::Allreduce(se, flags);
       
       if (this->eval_recv)
 	se.second = prob_t::instance().evaluation(se.first);
 
+      // stop together if someone reached the target
+      term.apply(flags);
+
       return true;  // we modified the solution
     }
     return false;
   }
 
+private:
+  // all the processes exchange together, they take the longest period
+  unsigned agree_period(unsigned p) {
+    unsigned q;
+    MPI::COMM_WORLD.Allreduce(&p, &q, 1, MPI::UNSIGNED, MPI::MAX);
+    return q;
+  }
+};
+
+
+// two levels of cooperation: the threads of a process share a pool of
+// solutions, and every global_period local exchanges the master thread
+// of each process puts the best solution of its pool through an MPI
+// exchange operation (mpi_ring_coop_op or mpi_reduce_coop_op, with a
+// period of 1) and inserts what it gets into the pool. Only the master
+// thread calls MPI, so MPI_THREAD_FUNNELED is enough.
+template <class prob_t, class _global_op>
+class hybrid_coop_op: public omp_blackboard_coop_op<prob_t> {
+  typedef omp_blackboard_coop_op<prob_t> base;
+public:
+  hybrid_coop_op(best_pool<prob_t>& shared_pool, const boost::shared_ptr<_global_op>& global_op, unsigned exchange_period, unsigned global_period, AsyncExchangePolicy exchange_policy=RANDOM, bool _eval_recv=false)
+    : base(shared_pool, exchange_period, exchange_policy, _eval_recv),
+      pool(shared_pool),
+      global(global_op),
+      gperiod(global_period*exchange_period),
+      gcycle(0)
+  {}
+
+  // the global period is counted in iterations: the local period may
+  // adapt differently in each process, the processes must still make
+  // the same number of global exchanges
+  void send(const typename prob_t::soleval_t& se)
+  {
+    base::send(se);
+    if (omp_get_thread_num()==0 && ++gcycle == gperiod) {
+      gcycle = 0;
+
+      typename prob_t::soleval_t best(se);
+      pool.get_best(best);
+      if ((*global)(best))
+	pool.insert(best);
+    }
+  }
+
+private:
+  best_pool<prob_t>& pool;
+  boost::shared_ptr<_global_op> global;   // shared by the copies of the threads
+  const unsigned gperiod;
+  unsigned gcycle;
 };
 
 
+
 #endif   // USE_MPI
 
 
 
+// In the synchronous mode, all the threads exchange at the same time
+// through the shared array. In the asynchronous mode, each thread posts
+// its solution in the mailbox to the next thread and takes whatever
+// its previous thread posted last, nobody waits.
 template <class prob_t>
 struct omp_ring_coop_op : public exchange_op<prob_t> {
-  omp_ring_coop_op(unsigned exchange_period, boost::shared_array<typename prob_t::soleval_t>& shared_vect, bool _eval_recv=false) 
+  typedef omp_mailbox<typename prob_t::soleval_t> mailbox_t;
+
+  omp_ring_coop_op(unsigned exchange_period, boost::shared_array<typename prob_t::soleval_t>& shared_vect, boost::shared_array<mailbox_t>& mailboxes, bool _eval_recv=false) 
     : exchange_op<prob_t>(exchange_period, _eval_recv),
-      rank(omp_get_thread_num()),
-      size(omp_get_max_threads()),
-      _shared(shared_vect)
+      _shared(shared_vect),
+      _mailboxes(mailboxes),
+      _delta(false),
+      _async(false)
   {  }
 
+  // only write the parts of the solution that changed since the
+  // previous exchange
+  void set_delta(bool on) { _delta = on; }
+
+  void set_async(bool on) { _async = on; }
+  bool async() const { return _async; }
+
+  // the op is copied by each thread, so the rank is the one of the
+  // calling thread
   void send(const typename prob_t::soleval_t& se)
   {
     if (++(this->cycle) == this->period) {
-      const unsigned send_to = rank==size-1 ? 0 : rank+1;
-
-      _shared[send_to] = se;
+      const unsigned rank = omp_get_thread_num();
+      const unsigned size = omp_get_num_threads();
+
+      if (_async) {
+	// the mailbox of the edge rank -> rank+1
+	mailbox_t& box = _mailboxes[rank];
+	copy(box.back(), se);
+	box.post();
+      } else {
+	const unsigned send_to = rank==size-1 ? 0 : rank+1;
+	copy(_shared[send_to], se);
+      }
     }
   }
 
@@ -479,10 +1006,20 @@ struct omp_ring_coop_op : public exchange_op<prob_t> {
   {
     if (this->cycle == this->period) {
       this->cycle=0;
+      const unsigned rank = omp_get_thread_num();
+      const unsigned size = omp_get_num_threads();
       const unsigned recv_from = rank==0 ? size-1 : rank-1;
+
+      if (_async) {
+	const typename prob_t::soleval_t* m = _mailboxes[recv_from].take();
+	if (m==0) return false;     // nothing new
+	se = *m;
+      } else {
 #pragma omp barrier
-      se = _shared[recv_from];
+	se = _shared[recv_from];
+	termination::instance().agree();
 #pragma omp barrier
+      }
       if (this->eval_recv)
 	se.second = prob_t::instance().evaluation(se.first);
 
@@ -492,23 +1029,160 @@ struct omp_ring_coop_op : public exchange_op<prob_t> {
   }
 
 private:
-  const unsigned rank;
-  const unsigned size;
+  // the threads of the synchronous mode would need another barrier to
+  // agree on a period, they keep theirs
+  unsigned agree_period(unsigned p) { return _async ? p : this->period; }
+
+  void copy(typename prob_t::soleval_t& dst, const typename prob_t::soleval_t& se) const {
+    if (_delta) {
+      wire_delta<typename prob_t::sol_t>::assign(dst.first, se.first);
+      dst.second = se.second;
+    } else
+      dst = se;
+  }
+
   boost::shared_array<typename prob_t::soleval_t>& _shared;
+  boost::shared_array<mailbox_t>& _mailboxes;
+  bool _delta;
+  bool _async;
+};
+
+
+
+// the latest solution of a thread in omp_topology_coop_op, on its own
+// cache line
+template <class prob_t>
+struct published_solution {
+  omp_snapshot<typename prob_t::soleval_t> se;
+  char _pad[cache_line_size];
+};
+
+
+// island model on any topology (see topology.hh): each thread publishes
+// its solution as an immutable snapshot, and takes the best of its
+// solution and the latest ones of its peers of the epoch. Nobody waits.
+template <class prob_t, class _topology>
+struct omp_topology_coop_op : public exchange_op<prob_t> {
+  typedef boost::shared_ptr<const typename prob_t::soleval_t> sol_ptr;
+
+  omp_topology_coop_op(unsigned exchange_period, boost::shared_array<published_solution<prob_t> >& published, const _topology& topology=_topology(), bool _eval_recv=false) 
+    : exchange_op<prob_t>(exchange_period, _eval_recv),
+      _published(published),
+      topo(topology),
+      epoch(0),
+      to(),
+      from(),
+      seen(),
+      versions()
+  {  }
+
+  // the op is copied by each thread, so the rank is the one of the
+  // calling thread
+  void send(const typename prob_t::soleval_t& se)
+  {
+    if (++(this->cycle) == this->period) {
+      const sol_ptr mine(new typename prob_t::soleval_t(se));
+      _published[omp_get_thread_num()].se.store(mine);
+    }
+  }
+
+
+  bool recv(typename prob_t::soleval_t& se)
+  {
+    if (this->cycle == this->period) {
+      this->cycle=0;
+      topo.peers(omp_get_thread_num(), omp_get_num_threads(), epoch++, to, from);
+
+      if (seen.size() < (unsigned)omp_get_num_threads()) {
+	seen.resize(omp_get_num_threads());
+	versions.resize(omp_get_num_threads(), 0);
+      }
+
+      sol_ptr best;
+      for (unsigned i=0; i<from.size(); ++i) {
+	// the lock is only taken for the peers that published since
+	_published[from[i]].se.refresh(seen[from[i]], versions[from[i]]);
+	const sol_ptr& s = seen[from[i]];
+	if (s && s->second < (best ? best->second : se.second))
+	  best = s;
+      }
+      if (!best) return false;
+
+      se = *best;
+      if (this->eval_recv)
+	se.second = prob_t::instance().evaluation(se.first);
+
+      return true;  // we modified the solution
+    }
+    return false;
+  }
+
+private:
+  boost::shared_array<published_solution<prob_t> >& _published;
+  const _topology topo;
+  unsigned long epoch;
+  std::vector<unsigned> to, from;
+  std::vector<sol_ptr> seen;               // latest solution taken from each peer
+  std::vector<unsigned long> versions;     // and its version
+};
+
+
+
+// best solution of the exchanges of one epoch in the asynchronous
+// mode of omp_reduce_coop_op
+template <class prob_t>
+struct epoch_best {
+  epoch_best(const typename prob_t::soleval_t& _se, unsigned long _epoch)
+    : se(_se), epoch(_epoch)
+  {}
+
+  const typename prob_t::soleval_t se;
+  const unsigned long epoch;
 };
 
+// one slot per epoch, on its own cache line
+template <class prob_t>
+struct epoch_slot {
+  omp_snapshot<epoch_best<prob_t> > best;
+  char _pad[cache_line_size];
+};
 
 
+// In the synchronous mode, the threads put their solution in the shared
+// one, wait for each other and all take the best.
+//
+// In the asynchronous mode, the n-th exchange of every thread belongs
+// to epoch n, which has a slot in a small ring of slots. A thread
+// publishes its solution as an immutable snapshot, replacing the one
+// in the slot with a compare-and-swap if it is better or from an older
+// epoch, and takes the best published so far in its epoch. Nobody
+// waits and nothing needs to be reset. A thread that falls behind by
+// more than the number of slots gets the best of a later epoch.
 template <class prob_t>
 struct omp_reduce_coop_op : public exchange_op<prob_t> {
-  omp_reduce_coop_op(unsigned exchange_period, typename prob_t::soleval_t* shared_individu, bool _eval_recv=false) 
+  typedef epoch_best<prob_t> best_t;
+  typedef boost::shared_ptr<const best_t> best_ptr;
+
+  omp_reduce_coop_op(unsigned exchange_period, typename prob_t::soleval_t* shared_individu, boost::shared_array<epoch_slot<prob_t> >& epoch_slots, unsigned n_slots, bool _eval_recv=false) 
     : exchange_op<prob_t>(exchange_period, _eval_recv),
-      _shared(shared_individu)
+      _shared(shared_individu),
+      _slots(epoch_slots),
+      _n_slots(n_slots),
+      _epoch(0),
+      _async(false),
+      _mine()
   {  }
 
+  void set_async(bool on) { _async = on; }
+  bool async() const { return _async; }
+
   void send(const typename prob_t::soleval_t& se)
   {
     if (++(this->cycle) == this->period) {
+      if (_async) {
+	publish(se);
+	return;
+      }
 #pragma omp critical (OMP_ACCESS_SHARED_SOL)
       {
 	if (se.second < _shared->second) {
@@ -523,17 +1197,26 @@ struct omp_reduce_coop_op : public exchange_op<prob_t> {
   {
     if (this->cycle == this->period) {
       this->cycle=0;
-      
-      // wait to make sure everyone has done the send()
+
+      if (_async) {
+	const best_ptr b = _slots[_epoch % _n_slots].best.load();
+	++_epoch;
+	// our own solution is still the best
+	if (!b || b==_mine) return false;
+	se = b->se;
+      } else {
+	// wait to make sure everyone has done the send()
 #pragma omp barrier
 
-      se = *_shared;
+	se = *_shared;
+	termination::instance().agree();
 
-      // wait to make sure everyone has finished doing the recv()
+	// wait to make sure everyone has finished doing the recv()
 #pragma omp barrier
 #pragma omp single nowait
-      {
-	_shared->second = std::numeric_limits<typename prob_t::eval_t>::max();
+	{
+	  _shared->second = std::numeric_limits<typename prob_t::eval_t>::max();
+	}
       }
 
       if (this->eval_recv)
@@ -545,10 +1228,32 @@ struct omp_reduce_coop_op : public exchange_op<prob_t> {
   }
 
 private:
+  // the threads of the synchronous mode would need another barrier to
+  // agree on a period, they keep theirs
+  unsigned agree_period(unsigned p) { return _async ? p : this->period; }
+
+  void publish(const typename prob_t::soleval_t& se) {
+    omp_snapshot<best_t>& slot = _slots[_epoch % _n_slots].best;
+
+    // the copy is made before trying to publish it
+    _mine = best_ptr(new best_t(se, _epoch));
+    best_ptr cur = slot.load();
+    while (!cur || cur->epoch < _epoch || (cur->epoch == _epoch && se.second < cur->se.second)) {
+      // cur is updated when the slot changed
+      if (slot.compare_exchange(cur, _mine)) 
+	return;
+    }
+    _mine.reset();
+  }
+
   typename prob_t::soleval_t* _shared;
+  boost::shared_array<epoch_slot<prob_t> >& _slots;
+  const unsigned _n_slots;
+  unsigned long _epoch;    // of the next exchange of this thread
+  bool _async;
+  best_ptr _mine;          // what this thread published in the current epoch
 };
 
-
 }
 
 #endif
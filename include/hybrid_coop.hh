@@ -0,0 +1,130 @@
+#ifndef HYBRID_COOP_HH
+#define HYBRID_COOP_HH
+
+/*
+metl: A generic framework for sequential and parallel metaheuristics
+Copyright (c) 2005-2015, Sylvain Ouellet
+
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+
+*/
+
+
+#ifdef USE_MPI
+
+#include "metl_def.hh"
+
+#ifdef _OPENMP
+#ifndef INCLUDED_OMP_H   
+#define INCLUDED_OMP_H   
+#include <omp.h>         
+#endif                   
+#else                    
+#include "omp_stub.h"    
+#endif
+
+#include "exchange_oper.hh"
+
+#include <boost/shared_ptr.hpp>
+
+namespace metl {
+
+// hierarchical cooperation for one MPI process per node: the OpenMP
+// threads of a process cooperate through a shared pool every
+// exchange_period iterations, and the processes exchange the best
+// solution of their pools with _global_op (mpi_ring_coop_op or
+// mpi_reduce_coop_op) every global_period*exchange_period iterations,
+// see hybrid_coop_op.
+template <class _metaheuristic, template <class> class _global_op = mpi_ring_coop_op>
+class hybrid_coop : public _metaheuristic {
+  typedef _metaheuristic base;
+  typedef typename _metaheuristic::problem_type prob_t;
+  typedef _global_op<prob_t> global_op_t;
+
+public:
+    using base::operator();
+    using base::generator;
+
+  hybrid_coop(unsigned exchange_period=10, unsigned global_period=10, AsyncExchangePolicy exchange_policy=RANDOM, unsigned pool_size=10, bool eval_recv=false)
+    : p_size(pool_size),
+      bp(new best_pool<prob_t>(p_size)),
+      global(new global_op_t(1, eval_recv)),
+      xchange_op(*bp, global, exchange_period, global_period, exchange_policy, eval_recv)
+  {}
+
+  // grow or shrink the local exchange period online, between
+  // min_period and max_period (see adaptive_period). The global period
+  // does not change.
+  void set_adaptive(unsigned min_period, unsigned max_period, double max_comm_ratio=0.05) { xchange_op.set_adaptive(min_period, max_period, max_comm_ratio); }
+
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se_in) {
+    typename prob_t::soleval_t se(se_in);
+    CHECK_EVAL(se);
+
+    // a new pool for each run
+    *bp = best_pool<prob_t>(p_size);
+    checkpoint::instance().restore_pool(*bp);
+
+    // the processes stop together at a global exchange
+    termination::instance().open(true);
+#pragma omp parallel 
+    {
+      typename prob_t::soleval_t tsol = se;
+      hybrid_coop<_metaheuristic, _global_op> thread_copy(*this);
+      tsol = thread_copy.runme(tsol);
+      bp->insert(tsol);
+    }
+    termination::instance().close();
+
+    bp->get_best(se);
+    sol_reducter<prob_t>::Allreduce(se);
+
+    CHECK_EVAL(se);
+    return se;
+  }
+
+  const std::string name() const { return "Hybrid OpenMP pool and MPI coop. algo., base algorithm=(" + base::name()+")" ; }
+  
+
+private:
+  unsigned p_size;
+  // the copies of the threads share the pool and the MPI operation
+  boost::shared_ptr<best_pool<prob_t> > bp;
+  boost::shared_ptr<global_op_t> global;
+  hybrid_coop_op<prob_t, global_op_t> xchange_op;
+
+  typename prob_t::soleval_t runme(const typename prob_t::soleval_t& sol) {
+    return base::operator()(sol, xchange_op);
+  }
+
+
+  // it is not possible to use 2 cooperative algorithm
+  template <class PE>
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se_in, PE& periodic_exchange);
+ 
+};
+
+}
+
+#endif   // USE_MPI
+
+
+#endif
@@ -41,11 +41,15 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 // cooperative communication schemes
 #include "mpi_blackboard_coop.hh"
+#include "mpi_rma_blackboard_coop.hh"
 #include "omp_blackboard_coop.hh"
 #include "mpi_ring_coop.hh"
 #include "omp_ring_coop.hh"
 #include "mpi_reduce_coop.hh"
+#include "hybrid_coop.hh"
 #include "omp_reduce_coop.hh"
+#include "omp_topology_coop.hh"
+#include "mpi_topology_coop.hh"
 
 
 #endif
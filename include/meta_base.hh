@@ -33,6 +33,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "abstract_crossover.hh"
 #include "abstract_mutation.hh"
 #include "separable_neighborhood.hh"
+#include "move_block.hh"
 
 #include "metl_def.hh"
 
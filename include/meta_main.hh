@@ -28,6 +28,8 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 #include "metl_def.hh"
+#include "budget.hh"
+#include "checkpoint.hh"
 
 #ifdef USE_MPI
 #ifdef HAVE_MPIPP_H     
@@ -47,8 +49,9 @@ namespace boost {
 #endif
 
 
+// SPRNG, or philox_rand with -DUSE_PHILOX (see metl_rng.hh)
 namespace metl {
-sprng_rand rng;
+rng_type rng;
 }
 
 extern int _main(int argc, char* argv[]);
@@ -59,14 +62,24 @@ int main(int argc, char* argv[])
   std::cout << "Compiled without NDEBUG, will be slow." << std::endl;
 #endif
 #ifdef USE_MPI
+#ifdef _OPENMP
+  // hybrid_coop calls MPI from the master thread of an OpenMP team
+  if (MPI::Init_thread(argc, argv, MPI::THREAD_FUNNELED) < MPI::THREAD_FUNNELED)
+    std::cerr << "WARNING: the MPI library does not support MPI_THREAD_FUNNELED" << std::endl;
+#else
   MPI::Init(argc, argv);
+#endif
 #endif
   metl::rng.init();
+  // the time budgets count from the start of the job
+  metl::budget::instance().start();
 #ifdef _OPENMP
   std::cout << "Using OpenMP. omp_get_max_threads=" << omp_get_max_threads() << std::endl;
 #endif
 
   _main(argc, argv);
+  // the last checkpoints are on disk before leaving
+  metl::checkpoint::instance().finish();
 
 #ifdef USE_MPI
   MPI::Finalize();
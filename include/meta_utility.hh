@@ -27,7 +27,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 
-#include <sprng_rand.hh>
+#include <metl_rng.hh>
 #include <sync_rng.hh>
 #include <Matrix.hh>
 #include <utrig_matrix.hh>
@@ -27,17 +27,16 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 */
 
-// this is the buffer size used for MPI communications. It has to be enough to hold a serialized solution and it's evaluation
-#ifndef METL_BUF_SIZE
-#define METL_BUF_SIZE 10000
+// size of a cache line. Per-thread data that is written often is padded to this size to avoid false sharing.
+#ifndef METL_CACHE_LINE_SIZE
+#define METL_CACHE_LINE_SIZE 64
 #endif
 
 
 
 
-
 namespace metl {
-  const unsigned max_buf_size = METL_BUF_SIZE;
+  const unsigned cache_line_size = METL_CACHE_LINE_SIZE;
 }
 
 #endif
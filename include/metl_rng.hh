@@ -0,0 +1,50 @@
+#ifndef METL_RNG_HH
+#define METL_RNG_HH
+
+/*
+metl: A generic framework for sequential and parallel metaheuristics
+Copyright (c) 2005-2015, Sylvain Ouellet
+
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+
+*/
+
+// metl::rng, the generator of the searches: SPRNG, or the header-only
+// philox_rand when compiled with -DUSE_PHILOX. meta_main.hh defines it.
+#ifdef USE_PHILOX
+#include "philox_rand.hh"
+#else
+#include "sprng_rand.hh"
+#endif
+
+namespace metl {
+
+#ifdef USE_PHILOX
+typedef philox_rand rng_type;
+#else
+typedef sprng_rand rng_type;
+#endif
+
+extern rng_type rng;
+
+}
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef MOVE_BLOCK_HH
+#define MOVE_BLOCK_HH
+
+/*
+metl: A generic framework for sequential and parallel metaheuristics
+Copyright (c) 2005-2015, Sylvain Ouellet
+
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+
+*/
+
+// blocks of moves sent by a neighborhood to its operation. When the
+// move defines batch_size>1 and the operation defines batch_costs=1,
+// the neighborhood fills a block, the costs of the whole block are
+// computed with _move::cost_batch() and the operation gets them all at
+// once through:
+//
+//   unsigned block(const _move* moves, const eval_t* costs, unsigned n);
+//
+// which returns n, and
+//
+//   bool stopped();
+//
+// true when the operation needs no more moves (first_improve_ns), the
+// costs of the next blocks are then not computed. The other operations
+// get the moves one at a time through operator(), as before the
+// blocks: those that do not define batch_costs, and those that apply
+// moves (first_improve, metropolis) since each move would make the
+// costs of the rest of its block stale.
+
+#include <math.h>
+#include <assert.h>
+#include <iostream>
+
+namespace metl {
+
+
+// compute the costs of n moves with _move::cost_batch. In debug mode,
+// check them against the cost of each move.
+template <class prob_t, class _move>
+inline void batch_cost(const typename prob_t::sol_t& sol, const _move* moves, 
+		       typename prob_t::eval_t* costs, unsigned n) {
+  _move::cost_batch(sol, moves, costs, n);
+#ifndef NDEBUG
+  for (unsigned k=0; k<n; ++k) {
+    const typename prob_t::eval_t c = moves[k].internal_cost(sol);
+    if (!(fabs(costs[k] - c)<0.1)) {
+      std::cerr << "cost_batch returns wrong result: "<< costs[k] << " expected: " << c << std::endl;
+      assert(0);
+    }
+  }
+#endif
+}
+
+
+// _op::batch_costs, 0 if _op does not define it
+template <class _op>
+struct op_batch_costs {
+private:
+  typedef char yes[1];
+  typedef char no[2];
+  template <int> struct tag {};
+  template <class T> static yes& test(tag<T::batch_costs>*);
+  template <class T> static no& test(...);
+
+  template <class T, bool defined> struct get { enum { value = 0 }; };
+  template <class T> struct get<T, true> { enum { value = T::batch_costs }; };
+
+public:
+  enum { value = get<_op, sizeof(test<_op>(0))==sizeof(yes)>::value };
+};
+
+
+// the size of the blocks sent to _op: 1 when the move has no
+// cost_batch or when _op takes the moves one at a time
+template <class _op, unsigned N>
+struct op_block_size {
+  enum { value = op_batch_costs<_op>::value ? N : 1 };
+};
+
+template <class _op>
+struct op_block_size<_op, 1> {
+  enum { value = 1 };
+};
+
+
+// used by neighborhoods to send their moves to op. Call operator() for
+// every move, and flush() at the end of the (partial) neighborhood.
+template <class prob_t, class _op, class _move, 
+	  unsigned N=op_block_size<_op, _move::batch_size>::value>
+class move_block {
+public:
+  move_block(_op& op, const typename prob_t::sol_t& sol)
+    : _o(op), s(sol), n(0)
+  {}
+
+  inline void operator()(const _move& m) {
+    moves[n++] = m;
+    if (n==N) flush();
+  }
+
+  void flush() {
+    if (n==0 || _o.stopped()) {
+      n=0;
+      return;
+    }
+    batch_cost<prob_t>(s, moves, costs, n);
+    _o.block(moves, costs, n);
+    n=0;
+  }
+
+private:
+  _op& _o;
+  const typename prob_t::sol_t& s;
+  _move moves[N];    //REQUIS: move must be default constructible
+  typename prob_t::eval_t costs[N];
+  unsigned n;
+
+  move_block(const move_block&);
+  move_block& operator=(const move_block&);
+};
+
+
+// no blocks, moves are sent one at a time
+template <class prob_t, class _op, class _move>
+class move_block<prob_t, _op, _move, 1> {
+public:
+  move_block(_op& op, const typename prob_t::sol_t& sol)
+    : _o(op)
+  {}
+
+  inline void operator()(const _move& m) {
+    _o(m);
+  }
+
+  inline void flush() {}
+
+private:
+  _op& _o;
+};
+
+
+}
+
+#endif
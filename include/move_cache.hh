@@ -0,0 +1,233 @@
+#ifndef MOVE_CACHE_HH
+#define MOVE_CACHE_HH
+
+/*
+metl: A generic framework for sequential and parallel metaheuristics
+Copyright (c) 2005-2015, Sylvain Ouellet
+
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+
+*/
+
+// a cache of the move costs of a neighborhood, for the algorithms that
+// evaluate the whole neighborhood at each iteration (descent, tabu)
+// when there is no gain structure for the problem.
+//
+// The neighborhood must send the same moves in the same order at every
+// evaluation. The moves must define:
+//
+//   void reads(std::vector<unsigned>& elements) const;
+//   void writes(std::vector<unsigned>& elements) const;
+//
+// which append the indexes of the elements of the solution that the
+// cost of the move depends on, and the ones the move modifies. When a
+// move is applied, only the cached costs of the moves that read an
+// element it wrote are computed again. This pays off when the moves
+// depend on few elements. In debug mode, every cached cost is checked.
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <assert.h>
+#include <iostream>
+
+#ifdef _OPENMP
+#ifndef INCLUDED_OMP_H   
+#define INCLUDED_OMP_H   
+#include <omp.h>         
+#endif                   
+#else                    
+#include "omp_stub.h"    
+#endif
+
+#include "move_block.hh"
+
+namespace metl {
+
+
+// sequential evaluation of the cached neighborhood. It is also the gain
+// structure of the algorithm: update_after() invalidates the costs and
+// init() forgets all of them.
+template <class _nh_t, class _move, class prob_t>
+class cached_nh_eval {
+public:
+  cached_nh_eval(_nh_t& neighborhood) 
+    : nh(neighborhood),
+      _moves(),
+      _costs(),
+      _valid(),
+      _readers(),
+      _elements(),
+      _built(false)
+  {}
+
+  template<class _op>
+  inline void operator()(_op& op, const typename prob_t::sol_t& sol) {
+    if (!_built) build(sol);
+
+    typename _op::thread_op top(op);
+    eval_range(top, sol, 0, _moves.size());
+    top.commit();
+  }
+
+  // the solution was replaced
+  void init(const typename prob_t::sol_t& sol) {
+    std::fill(_valid.begin(), _valid.end(), 0);
+  }
+
+  void update_before(const _move& m, const typename prob_t::sol_t& sol) {}
+
+  // m was applied, invalidate the moves that read what it wrote
+  void update_after(const _move& m, const typename prob_t::sol_t& sol) {
+    _elements.clear();
+    m.writes(_elements);
+    for (unsigned k=0; k<_elements.size(); ++k) {
+      const std::vector<unsigned>& r = _readers[_elements[k]];
+      for (unsigned i=0; i<r.size(); ++i) 
+	_valid[r[i]] = 0;
+    }
+  }
+
+  // number of moves in the neighborhood
+  unsigned size() const { return _moves.size(); }
+
+protected:
+  // refresh the invalid costs of moves [begin,end) and send the moves
+  // to op. Contiguous invalid moves are evaluated together (see
+  // move_block.hh).
+  template<class _thread_op>
+  void eval_range(_thread_op& op, const typename prob_t::sol_t& sol, unsigned begin, unsigned end) {
+    unsigned i=begin;
+    while (i<end) {
+      if (!_valid[i]) {
+	unsigned j=i+1;
+	while (j<end && j-i<_move::batch_size && !_valid[j]) ++j;
+	batch_cost<prob_t>(sol, &_moves[i], &_costs[i], j-i);
+	for (; i<j; ++i) {
+	  _valid[i] = 1;
+	  op(_moves[i], _costs[i]);
+	}
+	continue;
+      }
+#ifndef NDEBUG
+      const typename prob_t::eval_t c = _moves[i].internal_cost(sol);
+      if (!(fabs(_costs[i] - c)<0.1)) {
+	std::cerr << "cached move cost is wrong: "<< _costs[i] << " expected: " << c 
+		  << " (check the reads() and writes() of the move)" << std::endl;
+	assert(0);
+      }
+#endif
+      op(_moves[i], _costs[i]);
+      ++i;
+    }
+  }
+
+  void build(const typename prob_t::sol_t& sol);
+
+  _nh_t& nh;
+  std::vector<_move> _moves;
+  std::vector<typename prob_t::eval_t> _costs;
+  std::vector<char> _valid;     // not vector<bool>, threads write it
+  std::vector<std::vector<unsigned> > _readers;   // moves that read each element
+  std::vector<unsigned> _elements;
+  bool _built;
+
+private:
+  // collects the moves of the neighborhood
+  struct recorder {
+    recorder(std::vector<_move>& m) : moves(m) {}
+
+    inline bool operator()(const _move& m) { 
+      moves.push_back(m); 
+      return false; 
+    }
+
+    std::vector<_move>& moves;
+  };
+};
+
+
+template <class _nh_t, class _move, class prob_t>
+void cached_nh_eval<_nh_t, _move, prob_t>::build(const typename prob_t::sol_t& sol) {
+  recorder rec(_moves);
+  nh(rec, sol);
+
+  _costs.resize(_moves.size());
+  _valid.assign(_moves.size(), 0);
+
+  for (unsigned i=0; i<_moves.size(); ++i) {
+    _elements.clear();
+    _moves[i].reads(_elements);
+    for (unsigned k=0; k<_elements.size(); ++k) {
+      if (_elements[k] >= _readers.size()) 
+	_readers.resize(_elements[k]+1);
+      _readers[_elements[k]].push_back(i);
+    }
+
+    // an element may be written by a move and read by none
+    _elements.clear();
+    _moves[i].writes(_elements);
+    for (unsigned k=0; k<_elements.size(); ++k)
+      if (_elements[k] >= _readers.size()) 
+	_readers.resize(_elements[k]+1);
+  }
+  _built = true;
+}
+
+
+// same, the moves are split between OpenMP threads. The invalid moves
+// are usually grouped (the moves that read the elements of the last
+// move), so the threads take small chunks of moves as they go.
+template <class _nh_t, class _move, class prob_t>
+class cached_nh_omp : public cached_nh_eval<_nh_t, _move, prob_t> {
+  typedef cached_nh_eval<_nh_t, _move, prob_t> base;
+
+public:
+  enum { chunk_size = 256 };
+
+  cached_nh_omp(_nh_t& neighborhood) : base(neighborhood) {}
+
+  template<class _op>
+  inline void operator()(_op& op, const typename prob_t::sol_t& sol) {
+    if (!base::_built) base::build(sol);
+
+    const unsigned size = base::_moves.size();
+    const int chunks = static_cast<int>((size+chunk_size-1)/chunk_size);
+    int k;
+
+#pragma omp parallel
+    {
+      typename _op::thread_op top(op);
+
+#pragma omp for schedule(dynamic) nowait
+      for (k=0; k<chunks; ++k) {
+	const unsigned begin = k*chunk_size;
+	base::eval_range(top, sol, begin, std::min(size, begin+chunk_size));
+      }
+      top.commit();
+    }
+  }
+};
+
+
+}
+
+#endif
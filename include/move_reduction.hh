@@ -29,7 +29,9 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <limits>
 #include <utility>
+#include <vector>
 #include "metl_def.hh"
+#include "metl_config.hh"
 
 #ifdef _OPENMP
 #ifndef INCLUDED_OMP_H   
@@ -41,21 +43,179 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #endif
 
 #include "mpi_reduce_op.hh"
+#include "budget.hh"
 
 namespace metl {
 
 
+// best move found so far by one thread, with its cost
+template<class _move, class eval_t>
+struct reduction_slot {
+  reduction_slot()
+    : m(),     //REQUIS: move must be default constructible
+      cost(std::numeric_limits<eval_t>::max())
+  {}
+
+  // forget the move
+  void clear() { cost = std::numeric_limits<eval_t>::max(); }
+
+  // a move must cost less than this to be kept
+  inline eval_t threshold() const { return cost; }
+
+  // keep the best of the two moves
+  void merge(const reduction_slot& o) {
+    if (o.cost < cost) {
+      m = o.m;
+      cost = o.cost;
+    }
+  }
+
+  _move m;
+  eval_t cost;
+};
+
+
+// the k best moves found so far by one thread, sorted by increasing cost
+template<class _move, class eval_t>
+struct k_best_slot {
+  typedef reduction_slot<_move, eval_t> entry_t;
+
+  explicit k_best_slot(unsigned k=1)
+    : _k(k)
+  {
+    moves.reserve(k);
+  }
+
+  // a move must cost less than this to enter the list
+  inline eval_t threshold() const {
+    return moves.size()<_k ? std::numeric_limits<eval_t>::max() : moves.back().cost;
+  }
+
+  // insert a move that costs less than threshold()
+  void insert(const _move& m, const eval_t& e) {
+    if (moves.size()==_k) moves.pop_back();
+
+    typename std::vector<entry_t>::iterator it = moves.end();
+    while (it!=moves.begin() && e<(it-1)->cost) --it;
+
+    it = moves.insert(it, entry_t());
+    it->m = m;
+    it->cost = e;
+  }
+
+  void clear() { moves.clear(); }
+
+  void merge(const k_best_slot& o) {
+    for (unsigned i=0; i<o.moves.size() && o.moves[i].cost<threshold(); ++i)
+      insert(o.moves[i].m, o.moves[i].cost);
+  }
+
+  std::vector<entry_t> moves;
+
+private:
+  unsigned _k;
+};
+
+
+// one slot per thread in the shared vector. The padding keeps the
+// slots of two threads from sharing a cache line.
+template<class _move, class eval_t>
+struct padded_reduction_slot : public reduction_slot<_move, eval_t> {
+private:
+  char _pad[cache_line_size];
+};
+
+
+template<class _move, class eval_t>
+struct padded_k_best_slot : public k_best_slot<_move, eval_t> {
+  explicit padded_k_best_slot(unsigned k=1) : k_best_slot<_move, eval_t>(k) {}
+private:
+  char _pad[cache_line_size];
+};
+
+
+// this is a per-thread view of a move selection kernel. It is created
+// inside the parallel region, keeps the thread's best moves in a local
+// slot (the kernel's slot_t) while the thread evaluates its part of the
+// neighborhood and merges it into the thread's padded slot once, when
+// commit() is called.
+template<class _kernel, class _move, class eval_t>
+class thread_reduction {
+  typedef typename _kernel::slot_t slot_t;
+
+public:
+  explicit thread_reduction(_kernel& kernel)
+    : k(kernel),
+      shared(kernel.thread_slot()),
+      best(shared),
+      evaluated(0)
+  {
+    best.clear();
+  }
+
+  inline bool operator()(const _move m) {
+    ++evaluated;
+    return k.select(best, m);
+  }
+
+  inline bool operator()(const _move m, const eval_t& e) {
+    ++evaluated;
+    return k.select(best, m, e);
+  }
+
+  // a block of moves with their costs (see move_block.hh)
+  enum { batch_costs = 1 };
+  inline bool stopped() const { return false; }
+  inline unsigned block(const _move* moves, const eval_t* costs, unsigned n) {
+    for (unsigned i=0; i<n; ++i)
+      k.select(best, moves[i], costs[i]);
+    evaluated += n;
+    return n;
+  }
+
+  // a move must cost less than this to be kept by this thread
+  inline eval_t threshold() const { return k.threshold(best); }
+
+  // write the best moves found by this thread in its slot, and charge
+  // the moves to the budget
+  inline void commit() {
+    shared.merge(best);
+    budget& b = budget::instance();
+    if (b.counts_moves()) b.add_moves(evaluated);
+  }
+
+private:
+  _kernel& k;
+  slot_t& shared;
+  slot_t best;
+  unsigned long evaluated;    // moves seen by this thread
+
+  thread_reduction(const thread_reduction&);
+  thread_reduction& operator=(const thread_reduction&);
+};
+
+
 // this is a base class. Each move selection policies that needs a reduction at the end should inherit from this class.
+// Derived classes must define select(slot, move) and select(slot, move, cost), which
+// update slot if the move should be kept, threshold(slot), the cost a
+// move must beat to be kept, and a thread_op typedef to the
+// thread_reduction used by parallel neighborhood evaluations.
 template<class prob_t, class _move>
 class move_reduction {
+public:
+  typedef reduction_slot<_move, typename prob_t::eval_t> slot_t;
+
 private:
-  std::vector<_move> best_moves;
-  std::vector<typename prob_t::eval_t> _bm_costs;
+  const int _n_threads;
+  std::vector<padded_reduction_slot<_move, typename prob_t::eval_t> > slots;
   const bool _using_mpi;
 
 #ifdef USE_MPI
-  MPI::Op pair_reduce_op;
-  MPI::Datatype type_pair;
+  int _rank;
+  minloc_pair<typename prob_t::eval_t> _loc_in, _loc_out;
+#if MPI_VERSION >= 3
+  MPI_Request _request;
+#endif
 #endif  
   _move& _bm;
 
@@ -64,78 +224,75 @@ protected:
 
 
   move_reduction(_move& best_move, bool using_mpi)
-    : best_moves(omp_get_max_threads(), _move()),  //REQUIS: move must be default constructible
-      _bm_costs(omp_get_max_threads(), std::numeric_limits<typename prob_t::eval_t>::max()),
+    : _n_threads(omp_get_max_threads()),
+      slots(_n_threads),
       _using_mpi(using_mpi),
 #ifdef USE_MPI
-      pair_reduce_op(),
-      type_pair(),
+      _rank(using_mpi ? MPI::COMM_WORLD.Get_rank() : 0),
+      _loc_in(),
+      _loc_out(),
 #endif
       _bm(best_move),
       _bm_cost(std::numeric_limits<typename prob_t::eval_t>::max())
-  {
-#ifdef USE_MPI
-    pair_reduce_op.Init(pair_reduce<std::pair<_move,typename prob_t::eval_t> >, 0);
-    type_pair = MPI::INT.Create_contiguous(sizeof(std::pair<_move,typename prob_t::eval_t>)/sizeof(int));
-    type_pair.Commit();
-#endif
-  }
+  {}
 
-  virtual ~move_reduction() {
-#ifdef USE_MPI
-    pair_reduce_op.Free();
-    type_pair.Free();
-#endif    
-  }
-
-  inline void update_thread_move_and_cost(const _move& m, const typename prob_t::eval_t e) {
-    if (omp_get_max_threads()>1) {
-      _bm_costs[omp_get_thread_num()] = e;
-      best_moves[omp_get_thread_num()] = m;
-    } else {
-      _bm_cost = e;
-      _bm = m;
-    }
-  }
+  virtual ~move_reduction() {}
 
-  inline typename prob_t::eval_t thread_cost() const {
-    return omp_get_max_threads()==1 ? _bm_cost : _bm_costs[omp_get_thread_num()];
+public:
+  // slot of the calling thread. Sequential evaluations write directly in it.
+  inline slot_t& thread_slot() {
+    return _n_threads==1 ? slots[0] : slots[omp_get_thread_num()];
   }
 
-public:
   // should always call reduce() before accessing the move or calling cost
   inline void reduce() {
-    if (omp_get_max_threads()>1) {
-
-      _bm_cost=_bm_costs[0];
-      unsigned min_i=0;
-      
-      for (int i=1; i<omp_get_max_threads(); ++i) {
-	if (_bm_costs[i] < _bm_cost) {
-	  _bm_cost = _bm_costs[i];
-	  min_i = i;
-	}
+    reduce_begin();
+    reduce_end();
+  }
+
+  // reduce() in two parts. With MPI, the processes agree on the rank
+  // that has the best move with a MINLOC reduction of (cost, rank), and
+  // that rank broadcasts its move. With MPI-3, the MINLOC reduction is
+  // started by reduce_begin() and completed by reduce_end(), work that
+  // does not need the move can be done in between.
+  void reduce_begin() {
+    unsigned min_i=0;
+    for (int i=1; i<_n_threads; ++i) {
+      if (slots[i].cost < slots[min_i].cost) {
+	min_i = i;
       }
-      _bm = best_moves[min_i];
     }
+    _bm_cost = slots[min_i].cost;
+    _bm = slots[min_i].m;
 
 #ifdef USE_MPI
     if (_using_mpi) {
-      std::pair<_move,typename prob_t::eval_t> x;
-      std::pair<_move,typename prob_t::eval_t> y;
-      x.first = _bm;
-      x.second=_bm_cost;
-
-      // FIXME: should use a serialization
-
-      //    cerr << "type_pair size:" << type_pair.Get_size() << endl;
-      //      std::cout << MPI::COMM_WORLD.Get_rank() << " before: " << x.second << " " << x.first << "    ";
-      
-      MPI::COMM_WORLD.Allreduce(&x,&y, 1, type_pair, pair_reduce_op);
-      //      std::cout << MPI::COMM_WORLD.Get_rank() << " after: " << y.second << " " << y.first << std::endl;
-      _bm = y.first;
-      _bm_cost = y.second;
+      _loc_in.value = _bm_cost;
+      _loc_in.rank = _rank;
+#if MPI_VERSION >= 3
+      MPI_Iallreduce(&_loc_in, &_loc_out, 1, minloc_traits<typename prob_t::eval_t>::type(), 
+		     MPI_MINLOC, MPI_COMM_WORLD, &_request);
+#else
+      MPI::COMM_WORLD.Allreduce(&_loc_in, &_loc_out, 1, minloc_traits<typename prob_t::eval_t>::type(), 
+				MPI::MINLOC);
+#endif
+    }
+#endif
+  }
 
+  void reduce_end() {
+#ifdef USE_MPI
+    if (_using_mpi) {
+#if MPI_VERSION >= 3
+      MPI_Wait(&_request, MPI_STATUS_IGNORE);
+#endif
+      // the move is sent as raw bytes, all processes run the same program
+      slot_t winner;
+      winner.m = _bm;
+      winner.cost = _bm_cost;
+      MPI::COMM_WORLD.Bcast(&winner, sizeof(slot_t), MPI::BYTE, _loc_out.rank);
+      _bm = winner.m;
+      _bm_cost = winner.cost;
     }
 #endif
   }
@@ -143,10 +300,8 @@ public:
   // forget the current best move
   void reset() {
     _bm_cost = std::numeric_limits<typename prob_t::eval_t>::max();
-    if (omp_get_max_threads()>1) {
-      for (unsigned i=0; i<_bm_costs.size(); ++i) { 
-	_bm_costs[i] = std::numeric_limits<typename prob_t::eval_t>::max();
-      }
+    for (int i=0; i<_n_threads; ++i) { 
+      slots[i].cost = std::numeric_limits<typename prob_t::eval_t>::max();
     }
   }
 
@@ -156,5 +311,80 @@ public:
   virtual bool operator()(const _move m)=0;
 };
 
+
+
+// this is a base class for the move selection policies that keep the k
+// best moves of a neighborhood evaluation instead of the best one.
+// reduce() merges the lists of the threads and selects, in increasing
+// order of cost, the moves that do not conflict with a move already
+// selected. _conflicts is a predicate: _conflicts()(a, b) is true if
+// moves a and b cannot be applied together (for instance, they modify
+// the same element of the solution).
+// Derived classes must define select() and thread_op like for move_reduction.
+// This reduction is not done across MPI processes.
+template<class prob_t, class _move, class _conflicts>
+class k_best_reduction {
+public:
+  typedef k_best_slot<_move, typename prob_t::eval_t> slot_t;
+  typedef typename slot_t::entry_t entry_t;
+
+private:
+  const int _n_threads;
+  std::vector<padded_k_best_slot<_move, typename prob_t::eval_t> > slots;
+  slot_t _all;
+  std::vector<entry_t> _selected;
+  _conflicts _conflict;
+
+protected:
+  k_best_reduction(unsigned k, const _conflicts& conflict=_conflicts())
+    : _n_threads(omp_get_max_threads()),
+      slots(_n_threads, padded_k_best_slot<_move, typename prob_t::eval_t>(k)),
+      _all(k),
+      _selected(),
+      _conflict(conflict)
+  {
+    _selected.reserve(k);
+  }
+
+  virtual ~k_best_reduction() {}
+
+public:
+  // slot of the calling thread. Sequential evaluations write directly in it.
+  inline slot_t& thread_slot() {
+    return _n_threads==1 ? slots[0] : slots[omp_get_thread_num()];
+  }
+
+  // should always call reduce() before accessing the selected moves
+  void reduce() {
+    _all.clear();
+    for (int i=0; i<_n_threads; ++i)
+      _all.merge(slots[i]);
+
+    _selected.clear();
+    for (unsigned i=0; i<_all.moves.size(); ++i) {
+      bool ok=true;
+      for (unsigned j=0; j<_selected.size() && ok; ++j)
+	ok = !_conflict(_all.moves[i].m, _selected[j].m);
+      if (ok) 
+	_selected.push_back(_all.moves[i]);
+    }
+  }
+
+  void reset() {
+    for (int i=0; i<_n_threads; ++i)
+      slots[i].clear();
+    _selected.clear();
+  }
+
+  // mutually compatible moves, sorted by increasing cost. Their costs
+  // were computed on the solution evaluated before reduce().
+  inline const std::vector<entry_t>& selected() const { return _selected; }
+
+  // cost of the best move
+  inline typename prob_t::eval_t cost() const { 
+    return _selected.empty() ? std::numeric_limits<typename prob_t::eval_t>::max() : _selected[0].cost;
+  }
+};
+
 }
 #endif
@@ -47,7 +47,14 @@ public:
       p_size(pool_size)
   {}
 
+  // exchange the solutions as deltas against the previous ones
+  void set_delta(bool on) { xchange_op.set_delta(on); }
+
   
+  // grow or shrink the exchange period online, between min_period and
+  // max_period (see adaptive_period)
+  void set_adaptive(unsigned min_period, unsigned max_period, double max_comm_ratio=0.05) { xchange_op.set_adaptive(min_period, max_period, max_comm_ratio); }
+
   typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se_in) {
     typename prob_t::soleval_t se(se_in);
     CHECK_EVAL(se);
@@ -60,10 +67,15 @@ public:
     MPI::COMM_WORLD.Barrier();  // wait until everyone is ready
 				// because otherwise it can affect the
 				// efficiency of the cooperative process
+
+    // the first worker at the target stops the others, then the
+    // master gets their tag_done at once
+    termination::instance().open_mpi();
     
     if (MPI::COMM_WORLD.Get_rank()==1) {
       // master
       best_pool<prob_t> bp(p_size);
+      checkpoint::instance().restore_pool(bp);
       xchange_op.master(bp);   // the master manages the best_pool
 
       bp.get_best(se);
@@ -75,6 +87,7 @@ public:
       // tell master that we are done
       xchange_op.tell_master(se);
     }
+    termination::instance().close();
 
     sol_reducter<prob_t>::Allreduce(se);
 
@@ -44,16 +44,28 @@ public:
     using base::generator;
 
   mpi_reduce_coop(unsigned exchange_period=10, bool eval_recv=false)
-    : ep(exchange_period), eval_re(eval_recv)
+    : ep(exchange_period), eval_re(eval_recv), adapt(false), min_p(0), max_p(0), ratio(0)
   {}
 
+  // grow or shrink the exchange period online, between min_period and
+  // max_period (see adaptive_period)
+  void set_adaptive(unsigned min_period, unsigned max_period, double max_comm_ratio=0.05) {
+    adapt = true;
+    min_p = min_period;
+    max_p = max_period;
+    ratio = max_comm_ratio;
+  }
 
   typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se_in) {
     typename prob_t::soleval_t se(se_in);
     CHECK_EVAL(se);
 
     mpi_reduce_coop_op<prob_t> xchange_op(ep, eval_re);
+    if (adapt) xchange_op.set_adaptive(min_p, max_p, ratio);
+    // the processes stop together at the next exchange
+    termination::instance().open(true);
     se = base::operator()(se, xchange_op);
+    termination::instance().close();
 
     sol_reducter<prob_t>::Allreduce(se);
 
@@ -67,6 +79,9 @@ public:
 private:
   unsigned ep;
   bool eval_re;
+  bool adapt;
+  unsigned min_p, max_p;
+  double ratio;
   // it is not possible to use 2 cooperative algorithm
   template <class PE>
   typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se_in, PE& periodic_exchange);
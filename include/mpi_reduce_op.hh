@@ -41,19 +41,11 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #ifdef USE_MPI
 
-// this is a workaround for a bug in BOOST 1_32. 
-// If your compiler does not support exceptions or you want to compile without exceptions, then define BOOST_NO_EXCEPTIONS.
-#ifdef BOOST_NO_EXCEPTIONS
-#undef BOOST_NO_EXCEPTIONS
-#include <boost/archive/archive_exception.hpp>
-#define BOOST_NO_EXCEPTIONS
-#endif
+#include <vector>
+#include <string.h>
+#include <stddef.h>
 
-#include <sstream>
-#include <boost/archive/binary_iarchive.hpp>
-#include <boost/archive/binary_oarchive.hpp>
-#include <boost/serialization/utility.hpp>
-#include <boost/serialization/vector.hpp>
+#include "wire.hh"
 
 #include "metl_config.hh"
 
@@ -74,30 +66,87 @@ namespace metl {
   }
 
 
-  template <class sol_t, class eval_t>
-  void pair_reduce_serialized(const void *invec, void *inoutvec, int len, const MPI::Datatype& datatype) {
+  // (value, rank) pairs reduced with the builtin MPI::MINLOC. The ties
+  // go to the lowest rank. Evaluations without a matching MPI pair type
+  // are reduced as doubles.
+  template <class eval_t>
+  struct minloc_traits {
+    typedef double value_t;
+    static MPI::Datatype type() { return MPI::DOUBLE_INT; }
+  };
+
+  template <>
+  struct minloc_traits<float> {
+    typedef float value_t;
+    static MPI::Datatype type() { return MPI::FLOAT_INT; }
+  };
+
+  template <>
+  struct minloc_traits<long> {
+    typedef long value_t;
+    static MPI::Datatype type() { return MPI::LONG_INT; }
+  };
+
+  template <>
+  struct minloc_traits<int> {
+    typedef int value_t;
+    static MPI::Datatype type() { return MPI::TWOINT; }
+  };
+
+  template <class eval_t>
+  struct minloc_pair {
+    typename minloc_traits<eval_t>::value_t value;
+    int rank;
+  };
+
+
+  // wire format of the solutions reduced by sol_reducter: a fixed size
+  // header followed by the serialized solution. The reduction compares
+  // the headers and copies the winner, the payload is never
+  // deserialized. The flags of all the processes are or-ed.
+  template <class eval_t>
+  struct wire_header {
+    eval_t eval;
+    unsigned long hash;   // hash of the payload, breaks the ties
+    unsigned flags;
+
+    // true if the solution of this header should be kept over rhs
+    inline bool better(const wire_header& rhs) const {
+      return eval < rhs.eval || (!(rhs.eval < eval) && hash < rhs.hash);
+    }
+  };
+
+
+  // FNV-1a
+  inline unsigned long wire_hash(const char* data, unsigned size) {
+    unsigned long h = 2166136261UL;
+    for (unsigned i=0; i<size; ++i) {
+      h ^= static_cast<unsigned char>(data[i]);
+      h *= 16777619UL;
+    }
+    return h;
+  }
+
+
+  template <class eval_t>
+  void header_reduce(const void *invec, void *inoutvec, int len, const MPI::Datatype& datatype) {
     const unsigned size = datatype.Get_size();
 
     const char* in = static_cast<const char*>(invec);
     char* inout = static_cast<char*>(inoutvec);
   
-    sol_t sol1, sol2;
-    eval_t eval1, eval2;
+    wire_header<eval_t> h1, h2;
 
-    //  cerr << "len: " << len << endl;
     for (int i=0; i<len; ++i) {
-      std::istringstream in_buf(std::string(in,size));
-      boost::archive::binary_iarchive ia(in_buf);
-      ia >> sol1 >> eval1;
-
-      std::istringstream inout_buf(std::string(inout,size));
-      boost::archive::binary_iarchive ioa(inout_buf);
-      ioa >> sol2 >> eval2;
+      // the buffers may not be aligned for the header
+      memcpy(&h1, in, sizeof(h1));
+      memcpy(&h2, inout, sizeof(h2));
 
-      //    cerr << "reduction: " << in[i].second << " " << inout[i].second << endl;
-      if (eval1 < eval2) {
+      const unsigned flags = h1.flags | h2.flags;
+      if (h1.better(h2)) {
 	memcpy(inout, in, size);
       }
+      memcpy(inout + offsetof(wire_header<eval_t>, flags), &flags, sizeof(flags));
       in+=size;
       inout+=size;
     }
@@ -106,60 +155,78 @@ namespace metl {
 
   template <class prob_t>
   struct sol_reducter {    // this is a singleton
+    typedef wire_header<typename prob_t::eval_t> header_t;
 
+    // every process gets the best solution. Ties are broken by the
+    // hash of the solutions, so the result does not depend on the
+    // order of the reduction.
     static void Allreduce(typename prob_t::soleval_t& se) {
+      unsigned flags = 0;
+      Allreduce(se, flags);
+    }
+
+    // flags is or-ed with the flags of the other processes
+    static void Allreduce(typename prob_t::soleval_t& se, unsigned& flags) {
       static sol_reducter<prob_t> instance(se);
 
-      std::ostringstream send_buf(std::ios::binary);
-      // serialize solution into buffer
-      boost::archive::binary_oarchive oa(send_buf);
-      const typename prob_t::soleval_t& cse=se;
-      oa << cse.first << cse.second;
-    
-      const std::string sbuf = send_buf.str();
-    
-      if (sbuf.size() > max_buf_size) {
-	std::cerr << "max_buf_size overflow" << std::endl;
-	abort();	
-      }
+      std::vector<char>& sbuf = instance.sbuf;
+      wire_encode<prob_t>(se, instance.payload);
+      sbuf.assign(sizeof(header_t), 0);
+      sbuf.insert(sbuf.end(), instance.payload.begin(), instance.payload.end());
 
-      if (sbuf.size() != instance.serialized_size) {
+      if (sbuf.size() != instance.wire_size) {
 	// REQUIS: serialized size must be the same !
 	std::cerr << "Serialized size must be constant" << std::endl;
 	abort();
       }
+
+      header_t h;
+      memset(&h, 0, sizeof(h));   // the padding is compared below
+      h.eval = se.second;
+      h.hash = wire_hash(&sbuf[sizeof(header_t)], sbuf.size()-sizeof(header_t));
+      h.flags = flags;
+      memcpy(&sbuf[0], &h, sizeof(h));
       
-      MPI::COMM_WORLD.Allreduce(sbuf.data(), instance.buf, 1, instance.type_pair, instance.pair_reduce_op);
-      // unserialize solution
-      std::istringstream receive_buf(std::string(instance.buf,instance.serialized_size));
-      boost::archive::binary_iarchive ia(receive_buf);
-      ia >> se.first >> se.second;
+      MPI::COMM_WORLD.Allreduce(&sbuf[0], &instance.rbuf[0], 1, instance.type_pair, instance.pair_reduce_op);
+
+      header_t r;
+      memcpy(&r, &instance.rbuf[0], sizeof(r));
+      flags = r.flags;
+      memcpy(&instance.rbuf[0] + offsetof(header_t, flags), &h.flags, sizeof(h.flags));
+
+      // unserialize solution, unless it is ours
+      if (memcmp(&instance.rbuf[0], &sbuf[0], instance.wire_size)==0) return;
+
+      wire_decode<prob_t>(&instance.rbuf[sizeof(header_t)], se);
     }
 
 
   private:
 
+    static unsigned payload_size(const typename prob_t::soleval_t& se) {
+      std::vector<char> buf;
+      wire_encode<prob_t>(se, buf);
+      return buf.size();
+    }
+
     sol_reducter(const typename prob_t::soleval_t& se) 
       : pair_reduce_op(),
 	type_pair(),
-	serialized_size(0)
+	wire_size(sizeof(header_t) + payload_size(se)),
+	rbuf(wire_size),
+	sbuf(),
+	payload()
     {
-    
-      pair_reduce_op.Init(pair_reduce_serialized<typename prob_t::sol_t, typename prob_t::eval_t>,0);
-      
-      std::ostringstream send_buf(std::ios::binary);
-      // serialize solution into buffer
-      boost::archive::binary_oarchive oa(send_buf);
-      
-      oa << se.first << se.second;
+      pair_reduce_op.Init(header_reduce<typename prob_t::eval_t>, 1);   // commutative
       
-      serialized_size = send_buf.str().size();
-      //      std::cout << "serialized solution size: " << serialized_size << std::endl;
-      type_pair = MPI::CHAR.Create_contiguous(serialized_size);
+      //      std::cout << "serialized solution size: " << wire_size << std::endl;
+      type_pair = MPI::CHAR.Create_contiguous(wire_size);
       type_pair.Commit();
     }
 
     ~sol_reducter() {
+      // this is a static, it can be destroyed after MPI::Finalize
+      if (MPI::Is_finalized()) return;
       pair_reduce_op.Free();
       type_pair.Free();
     }
@@ -167,11 +234,10 @@ namespace metl {
     sol_reducter(const sol_reducter&);    // forbid copy construction
     sol_reducter& operator=(sol_reducter); // forbid assignment
 
-    char buf[max_buf_size];
-    
     MPI::Op pair_reduce_op;  
     MPI::Datatype type_pair;
-    unsigned serialized_size;
+    unsigned wire_size;
+    std::vector<char> rbuf, sbuf, payload;
   };
 
 
@@ -47,12 +47,23 @@ public:
     : xchange_op(exchange_period, eval_recv)
   {}
 
+  // exchange the solutions as deltas against the previous ones
+  void set_delta(bool on) { xchange_op.set_delta(on); }
+
+
+  // grow or shrink the exchange period online, between min_period and
+  // max_period (see adaptive_period)
+  void set_adaptive(unsigned min_period, unsigned max_period, double max_comm_ratio=0.05) { xchange_op.set_adaptive(min_period, max_period, max_comm_ratio); }
 
   typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se_in) {
     typename prob_t::soleval_t se(se_in);
     CHECK_EVAL(se);
 
+    // the processes stop together at the next exchange
+    termination::instance().open(true);
     se = base::operator()(se, xchange_op);
+    termination::instance().close();
+
     sol_reducter<prob_t>::Allreduce(se);
 
     CHECK_EVAL(se);
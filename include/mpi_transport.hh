@@ -0,0 +1,149 @@
+#ifndef MPI_TRANSPORT_HH
+#define MPI_TRANSPORT_HH
+
+/*
+metl: A generic framework for sequential and parallel metaheuristics
+Copyright (c) 2005-2015, Sylvain Ouellet
+
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+
+*/
+
+#include "metl_def.hh"
+
+#ifdef USE_MPI
+#ifdef HAVE_MPIPP_H     
+#include <mpi++.h>
+#else
+#include <mpi.h>
+#endif  // HAVE_MPIPP_H
+
+#include <vector>
+#include <deque>
+
+namespace metl {
+
+// point to point messages of any size for the exchange operations.
+// Asynchronous sends use buffers from a pool. The buffer of a send goes
+// back to the pool when the send is complete, which is checked with
+// Testsome each time a new buffer is needed. Receives probe the
+// message first, so the receive buffer grows to the size of the
+// largest message.
+class mpi_transport {
+public:
+  mpi_transport()
+    : _buffers(),
+      _free(),
+      _requests(),
+      _pending(),
+      _next(0),
+      _rbuf(),
+      _indices()
+  {}
+
+  // wait for the pending sends, their buffers belong to this object
+  ~mpi_transport() {
+    if (!_requests.empty() && !MPI::Is_finalized())
+      MPI::Request::Waitall(_requests.size(), &_requests[0]);
+  }
+
+  // buffer for the next isend(). Fill it and call isend().
+  std::vector<char>& next_buffer() {
+    progress();
+    if (_free.empty()) {
+      _free.push_back(_buffers.size());
+      _buffers.push_back(std::vector<char>());    // deque: the other buffers do not move
+    }
+    _next = _free.back();
+    _buffers[_next].clear();
+    return _buffers[_next];
+  }
+
+  // send the buffer returned by next_buffer()
+  void isend(int dest, int tag) {
+    _free.pop_back();
+    std::vector<char>& b = _buffers[_next];
+    _requests.push_back(MPI::COMM_WORLD.Isend(data(b), b.size(), MPI::CHAR, dest, tag));
+    _pending.push_back(_next);
+  }
+
+  void send(const std::vector<char>& b, int dest, int tag) const {
+    MPI::COMM_WORLD.Send(data(b), b.size(), MPI::CHAR, dest, tag);
+  }
+
+  // receive a message, the buffer is valid until the next receive
+  const std::vector<char>& recv(int source, int tag, MPI::Status& status) {
+    MPI::COMM_WORLD.Probe(source, tag, status);
+    _rbuf.resize(status.Get_count(MPI::CHAR));
+    MPI::COMM_WORLD.Recv(data(_rbuf), _rbuf.size(), MPI::CHAR, 
+			 status.Get_source(), status.Get_tag(), status);
+    return _rbuf;
+  }
+
+  // number of sends not known to be complete
+  unsigned pending() const { return _requests.size(); }
+
+  // give the buffers of the completed sends back to the pool
+  void progress() {
+    if (_requests.empty()) return;
+
+    _indices.resize(_requests.size());
+    const int n = MPI::Request::Testsome(_requests.size(), &_requests[0], &_indices[0]);
+    if (n<=0) return;   // MPI_UNDEFINED (no active request) is negative
+
+    for (int k=0; k<n; ++k)
+      _free.push_back(_pending[_indices[k]]);
+
+    // the completed requests are now MPI::REQUEST_NULL, remove them
+    unsigned j=0;
+    for (unsigned i=0; i<_requests.size(); ++i) {
+      if (_requests[i] != MPI::REQUEST_NULL) {
+	_requests[j] = _requests[i];
+	_pending[j] = _pending[i];
+	++j;
+      }
+    }
+    _requests.resize(j);
+    _pending.resize(j);
+  }
+
+private:
+  static char* data(const std::vector<char>& b) {
+    return b.empty() ? 0 : const_cast<char*>(&b[0]);
+  }
+
+  std::deque<std::vector<char> > _buffers;
+  std::vector<unsigned> _free;          // buffers that can be used
+  std::vector<MPI::Request> _requests;  // pending sends
+  std::vector<unsigned> _pending;       // their buffers
+  unsigned _next;
+  std::vector<char> _rbuf;
+  std::vector<int> _indices;
+
+  mpi_transport(const mpi_transport&);
+  mpi_transport& operator=(const mpi_transport&);
+};
+
+}
+
+#endif  // USE_MPI
+
+#endif
@@ -48,6 +48,11 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "omp_stub.h"    
 #endif
 
+#include <sched.h>
+
+#include "separable_neighborhood.hh"
+#include "sorted_gain.hh"
+
 
 namespace metl {
 
@@ -62,7 +67,9 @@ struct basic_nh_eval {
   basic_nh_eval(_nh_t& neighborhood) : nh(neighborhood) {};
   template<class _op>
   inline void operator()(_op& op, const sol_t& sol) {
-    nh(op, sol);        // evaluate whole neighborhood
+    typename _op::thread_op top(op);
+    nh(top, sol);        // evaluate whole neighborhood
+    top.commit();
   }
 private:
   _nh_t& nh;
@@ -70,67 +77,248 @@ private:
 
 
 // Evaluate whole neighborhood using OMP to split the work on multiple processors using shared memory
+// _op must be a move_reduction. Each thread works through its own
+// thread_op so the best move stays local until the end of the loop.
+// If the neighborhood estimates its work, each thread gets a range of
+// the same cost (static schedule), otherwise a guided schedule is used.
 template <class _nh_t, class _move, class sol_t>
 struct ns_nh_omp {
-  ns_nh_omp(_nh_t& neighborhood) : nh(neighborhood) {};
+  ns_nh_omp(_nh_t& neighborhood) 
+    : nh(neighborhood),
+      partition(neighborhood, omp_get_max_threads())
+  {};
+
   template<class _op>
   inline void operator()(_op& op, const sol_t& sol) {
-    const int size = static_cast<int>(nh.size());
     int i;
 
-#pragma omp parallel for schedule(guided)
-    for (i=0; i<size; ++i) {
-      nh.iteration(op, sol, i);        // evaluate partial neighborhoods
+    if (partition.balanced()) {
+      const int parts = static_cast<int>(partition.parts());
+      int k;
+#pragma omp parallel
+      {
+	typename _op::thread_op top(op);
+
+#pragma omp for schedule(static,1) nowait
+	for (k=0; k<parts; ++k) {
+	  const unsigned end = partition.end(k);
+	  for (unsigned j=partition.begin(k); j<end; ++j)
+	    nh.iteration(top, sol, j);        // evaluate partial neighborhoods
+	}
+	top.commit();
+      }
+      return;
+    }
+
+    const int size = static_cast<int>(nh.size());
+
+#pragma omp parallel
+    {
+      typename _op::thread_op top(op);
+
+#pragma omp for schedule(guided) nowait
+      for (i=0; i<size; ++i) {
+	nh.iteration(top, sol, i);        // evaluate partial neighborhoods
+      }
+      top.commit();
     }
   }
 private:
   _nh_t& nh;
+  const work_partition partition;
 };
 
 
-#ifdef USE_MPI
-// Evaluate whole neighborhood using MPI to split the work on multiple processors using message passing
+// evaluate the share of rank in a team of size workers. This is
+// "alternated" interlaced work distribution, it balances neighborhoods
+// where the partial neighborhoods get smaller as i increases.
+
+// size=2
+//p0: 0     3 4     7 8      11
+//p1:   1 2     5 6     9 10
+
+//size=3
+//p0: 0         5 6          11
+//p1:   1     4     7     10
+//p2:     2 3         8 9
+template <class _nh_t, class _op, class sol_t>
+inline void alternated_iterations(_nh_t& nh, _op& op, const sol_t& sol, unsigned rank, unsigned size) {
+  const unsigned ns = nh.size();
+  unsigned i=rank;
+  unsigned j=1;
+  while (i<ns) {
+    nh.iteration(op, sol, i);        // evaluate partial neighborhoods
+    if (j & 1) {
+      i=(j+1)*size-1-rank;
+    } else {
+      i=j*size+rank;
+    }
+    ++j;
+  }
+
+  // this is interlaced work distribution
+  //     for (unsigned i=rank; i<ns; i+=size) {
+  //       nh.iteration(op, sol, i);        // evaluate partial neighborhoods
+  //     }
+}
+
+
+
+// evaluate the share of rank in a team of size workers. Uses
+// partition if the neighborhood estimates its work (partition must
+// have size parts), the alternated interlaced distribution otherwise.
+template <class _nh_t, class _op, class sol_t>
+inline void partitioned_iterations(_nh_t& nh, _op& op, const sol_t& sol, 
+				   const work_partition& partition, unsigned rank, unsigned size) {
+  if (!partition.balanced()) {
+    alternated_iterations(nh, op, sol, rank, size);
+    return;
+  }
+  const unsigned end = partition.end(rank);
+  for (unsigned i=partition.begin(rank); i<end; ++i)
+    nh.iteration(op, sol, i);        // evaluate partial neighborhoods
+}
+
+
+// Evaluate whole neighborhood with a team of OpenMP threads that lives
+// for the whole search. ns_nh_omp opens a parallel region for every
+// evaluation, this one is opened once by the algorithm
+// (descent_ns_omp_pool, tabu_ns_omp_pool): thread 0 runs the search
+// and the other threads wait in serve() for the next evaluation.
 template <class _nh_t, class _move, class sol_t>
-struct ns_nh_mpi {
-  ns_nh_mpi(_nh_t& neighborhood) : nh(neighborhood) {};
+class ns_nh_omp_pool {
+public:
+  ns_nh_omp_pool(_nh_t& neighborhood) 
+    : nh(neighborhood),
+      // nested parallel regions usually have a single thread
+      _size(omp_in_parallel() ? 1 : omp_get_max_threads()),
+      partition(neighborhood, _size),
+      _generation(0),
+      _done(0),
+      _stop(false),
+      _op_t(0),
+      _sol(0),
+      _sweep(0)
+  {}
+
+  // number of threads asked for the team
+  unsigned size() const { return _size; }
+
   template<class _op>
   inline void operator()(_op& op, const sol_t& sol) {
-    const unsigned rank = MPI::COMM_WORLD.Get_rank();
-    const unsigned size = MPI::COMM_WORLD.Get_size();
-    const unsigned ns = nh.size();
-
-    // this is "alternated" interlaced work distribution.
-
-    // size=2
-    //p0: 0     3 4     7 8      11
-    //p1:   1 2     5 6     9 10
-
-    //size=3
-    //p0: 0         5 6          11
-    //p1:   1     4     7     10
-    //p2:     2 3         8 9
-
-    unsigned i=rank;
-    unsigned j=1;
-    while (i<ns) {
-      //      std::cerr << rank << "   " << i << std::endl;
-      nh.iteration(op, sol, i);        // evaluate partial neighborhoods
-      if (j & 1) {
-	i=(j+1)*size-1-rank;
-      } else {
-	i=j*size+rank;
+    // the runtime may give fewer threads than asked (OMP_THREAD_LIMIT,
+    // OMP_DYNAMIC), the work is split among those in the team. A pool
+    // of one thread is called outside of any team of its own (in a
+    // cooperation for instance) and keeps its size.
+    if (_size > 1) {
+      const unsigned team = omp_get_num_threads();
+      if (team != _size) {
+	_size = team;
+	partition = work_partition(nh, team);
+      }
+    }
+
+    _op_t = &op;
+    _sol = &sol;
+    _sweep = &ns_nh_omp_pool::template sweep<_op>;
+    _done = 0;
+#pragma omp flush
+    ++_generation;   // wake up the workers
+#pragma omp flush
+
+    sweep<_op>(*this, 0);
+
+    // wait for the workers to finish their share
+    unsigned spins=0;
+    while (_done < _size-1) {
+      spin_wait(spins);
+    }
+#pragma omp flush
+  }
+
+  // workers loop here until release() is called
+  void serve() {
+    const unsigned rank = omp_get_thread_num();
+    unsigned seen = 0;
+    while (1) {
+      unsigned spins=0;
+      while (_generation==seen && !_stop) {
+	spin_wait(spins);
       }
-      ++j;
+#pragma omp flush
+      if (_stop) return;
+      seen = _generation;
+
+      (*_sweep)(*this, rank);
+
+#pragma omp flush
+#pragma omp atomic
+      ++_done;
+    }
+  }
+
+  // called by thread 0 when the search is done
+  void release() {
+    _stop = true;
+#pragma omp flush
+  }
+
+private:
+  template<class _op>
+  static void sweep(ns_nh_omp_pool& pool, unsigned rank) {
+    typename _op::thread_op top(*static_cast<_op*>(pool._op_t));
+    partitioned_iterations(pool.nh, top, *pool._sol, pool.partition, rank, pool._size);
+    top.commit();
+  }
+
+  static inline void spin_wait(unsigned& spins) {
+#pragma omp flush
+    if (++spins > 4096) {
+      // let the other threads run if the machine is oversubscribed
+      sched_yield();
+      spins = 0;
     }
+  }
+
+  _nh_t& nh;
+  unsigned _size;
+  work_partition partition;
+  volatile unsigned _generation;   // incremented for every evaluation
+  volatile unsigned _done;   // number of workers that finished the current evaluation
+  volatile bool _stop;
+
+  // the current evaluation
+  void* _op_t;
+  const sol_t* _sol;
+  void (*_sweep)(ns_nh_omp_pool&, unsigned);
+
+  ns_nh_omp_pool(const ns_nh_omp_pool&);
+  ns_nh_omp_pool& operator=(const ns_nh_omp_pool&);
+};
 
-    // this is interlaced work distribution
-//     for (unsigned i=rank; i<ns; i+=size) {
-//       nh.iteration(op, sol, i);        // evaluate partial neighborhoods
-//     }
 
+#ifdef USE_MPI
+// Evaluate whole neighborhood using MPI to split the work on multiple processors using message passing
+template <class _nh_t, class _move, class sol_t>
+struct ns_nh_mpi {
+  ns_nh_mpi(_nh_t& neighborhood) 
+    : nh(neighborhood),
+      rank(MPI::COMM_WORLD.Get_rank()),
+      size(MPI::COMM_WORLD.Get_size()),
+      partition(neighborhood, size)
+  {};
+
+  template<class _op>
+  inline void operator()(_op& op, const sol_t& sol) {
+    typename _op::thread_op top(op);
+    partitioned_iterations(nh, top, sol, partition, rank, size);
+    top.commit();
   }
 private:
   _nh_t& nh;
+  const unsigned rank;
+  const unsigned size;
+  const work_partition partition;
 };
 #endif
 
@@ -142,10 +330,12 @@ struct gain_nh_eval {
 
   template<class _op>
   void operator()(_op& op, const sol_t& sol) {
+    typename _op::thread_op top(op);
+
     // search the gain structure for the best possible move
     const typename _gain_t::iterator gend = g.end();
     for (typename _gain_t::iterator i = g.begin(); i!=gend; ++i) {
-      op(_move(i), *i);   // cost of the move is already available
+      top(_move(i), *i);   // cost of the move is already available
 
 #ifndef NDEBUG
       if (fabs(*i - _move(i).internal_cost(sol))>0.01) {
@@ -154,6 +344,7 @@ struct gain_nh_eval {
 #endif
 
     }
+    top.commit();
   }
 private:
   _gain_t& g;
@@ -161,6 +352,99 @@ private:
   gain_nh_eval& operator=(const gain_nh_eval&);
 };
 
+
+// search a separable_gain with OpenMP threads, one row at a time. It is
+// also the gain structure of the algorithm, the rows are updated by the
+// threads too. Rows can have very different lengths (upper triangular
+// gains), so the threads take them one by one.
+template <class _gain_t, class _move, class sol_t>
+struct ns_gain_omp {
+  ns_gain_omp(_gain_t& gain) : g(gain) {};
+
+  template<class _op>
+  void operator()(_op& op, const sol_t& sol) {
+    const int rows = static_cast<int>(g.rows());
+    int r;
+
+#pragma omp parallel
+    {
+      typename _op::thread_op top(op);
+
+#pragma omp for schedule(dynamic) nowait
+      for (r=0; r<rows; ++r) {
+	const typename _gain_t::iterator rend = g.row_end(r);
+	for (typename _gain_t::iterator i = g.row_begin(r); i!=rend; ++i) {
+	  top(_move(i), *i);   // cost of the move is already available
+
+#ifndef NDEBUG
+	  if (fabs(*i - _move(i).internal_cost(sol))>0.01) {
+#pragma omp critical (METL_NS_GAIN_OMP)
+	    std::cout << "bad gain : " << " gain:" << *i << " expected: " <<_move(i).cost(sol) << std::endl;
+	  }
+#endif
+	}
+      }
+      top.commit();
+    }
+  }
+
+  void init(const sol_t& sol) { g.init(sol); }
+
+  void update_before(const _move& m, const sol_t& sol) {
+    const int rows = static_cast<int>(g.rows());
+    int r;
+#pragma omp parallel for schedule(dynamic)
+    for (r=0; r<rows; ++r)
+      g.update_row_before(m, sol, r);
+  }
+
+  void update_after(const _move& m, const sol_t& sol) {
+    const int rows = static_cast<int>(g.rows());
+    int r;
+#pragma omp parallel for schedule(dynamic)
+    for (r=0; r<rows; ++r)
+      g.update_row_after(m, sol, r);
+  }
+
+private:
+  _gain_t& g;
+  ns_gain_omp(const ns_gain_omp&);
+  ns_gain_omp& operator=(const ns_gain_omp&);
+};
+
+
+// walk a sorted gain structure from the best move. A move that does not
+// cost less than the best move kept by op cannot be selected, and
+// neither can the ones after it.
+template <class _gain_t, class _move, class sol_t>
+struct gain_nh_eval<sorted_gain<_gain_t>, _move, sol_t> {
+  gain_nh_eval(sorted_gain<_gain_t>& gain) : g(gain) {};
+
+  template<class _op>
+  void operator()(_op& op, const sol_t& sol) {
+    typename _op::thread_op top(op);
+    typename tournament_tree<typename _gain_t::eval_t>::walker w(g.tree());
+    unsigned k;
+
+    while (w.next(k)) {
+      if (!(g.cost(k) < top.threshold())) break;
+
+      top(g.move(k), g.cost(k));
+
+#ifndef NDEBUG
+      if (fabs(g.cost(k) - g.move(k).internal_cost(sol))>0.01) {
+	std::cout << "bad gain : " << " gain:" << g.cost(k) << " expected: " << g.move(k).cost(sol) << std::endl;
+      }
+#endif
+    }
+    top.commit();
+  }
+private:
+  sorted_gain<_gain_t>& g;
+  gain_nh_eval(const gain_nh_eval&);
+  gain_nh_eval& operator=(const gain_nh_eval&);
+};
+
 }
 #endif
 
@@ -69,16 +69,25 @@ public:
       xchange_op(*bp, exchange_period, exchange_policy, eval_recv)
   {}
 
+  // grow or shrink the exchange period online, between min_period and
+  // max_period (see adaptive_period)
+  void set_adaptive(unsigned min_period, unsigned max_period, double max_comm_ratio=0.05) { xchange_op.set_adaptive(min_period, max_period, max_comm_ratio); }
+
   typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se_in) {
     typename prob_t::soleval_t se(se_in);
     CHECK_EVAL(se);
 
+    checkpoint::instance().restore_pool(*bp);
+
+    // the first thread at the target stops the others
+    termination::instance().open();
 #pragma omp parallel 
     {
       typename prob_t::soleval_t tsol = se;
       omp_blackboard_coop<_metaheuristic> thread_copy(*this);
       thread_copy.runme(tsol);
     }
+    termination::instance().close();
 
     bp->get_best(se);
     CHECK_EVAL(se);
@@ -94,8 +103,10 @@ private:
   boost::shared_ptr<best_pool<prob_t> > bp;   // this is a shared pool of best solutions
   omp_blackboard_coop_op<prob_t> xchange_op;
 
+  // the final solution of a thread is only in the pool if it was sent,
+  // it is not when the thread stopped at the target
   void runme(const typename prob_t::soleval_t& sol) {
-    base::operator()(sol, xchange_op);
+    bp->insert(base::operator()(sol, xchange_op));
   }
 
 
@@ -0,0 +1,117 @@
+#ifndef OMP_MAILBOX_HH
+#define OMP_MAILBOX_HH
+
+/*
+metl: A generic framework for sequential and parallel metaheuristics
+Copyright (c) 2005-2015, Sylvain Ouellet
+
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+
+*/
+
+#include "metl_def.hh"
+#include "metl_config.hh"
+
+#ifdef _OPENMP
+#ifndef INCLUDED_OMP_H   
+#define INCLUDED_OMP_H   
+#include <omp.h>         
+#endif                   
+#else                    
+#include "omp_stub.h"    
+#endif
+
+namespace metl {
+
+// a mailbox from one thread (the sender) to another (the receiver)
+// that keeps only the latest message. Neither side ever waits: there
+// are three buffers, the sender writes in one, the receiver reads
+// another, and the third holds the latest message. post() and take()
+// swap their buffer with the third one. Each message carries a
+// sequence number, so the receiver can tell how many it missed.
+template <class T>
+class omp_mailbox {
+public:
+  omp_mailbox()
+    : _back(0), _sent(0),
+      _state(1),
+      _front(2), _received(0)
+  {}
+
+  // sender: the buffer of the next message. It holds an old message.
+  T& back() { return _buf[_back].value; }
+
+  // sender: send the message written in back()
+  void post() {
+    _buf[_back].seq = ++_sent;
+#pragma omp flush
+    unsigned old;
+#pragma omp atomic capture
+    { old = _state; _state = _back | fresh; }
+    _back = old & index_mask;
+  }
+
+  // receiver: the latest message, or 0 if none arrived since the last
+  // call. The message is valid until the next call.
+  const T* take() {
+    unsigned s;
+#pragma omp atomic read
+    s = _state;
+    if (!(s & fresh)) return 0;
+
+#pragma omp atomic capture
+    { s = _state; _state = _front; }
+#pragma omp flush
+    _front = s & index_mask;
+    _received = _buf[_front].seq;
+    return &_buf[_front].value;
+  }
+
+  // receiver: sequence number of the last message taken
+  unsigned long received() const { return _received; }
+
+private:
+  static const unsigned fresh = 4;
+  static const unsigned index_mask = 3;
+
+  struct slot {
+    slot() : value(), seq(0) {}
+    T value;
+    unsigned long seq;
+    char _pad[cache_line_size];
+  };
+
+  slot _buf[3];
+
+  // the sender, the shared state and the receiver are on different cache lines
+  unsigned _back;
+  unsigned long _sent;
+  char _pad1[cache_line_size];
+  unsigned _state;
+  char _pad2[cache_line_size];
+  unsigned _front;
+  unsigned long _received;
+  char _pad3[cache_line_size];
+};
+
+}
+
+#endif
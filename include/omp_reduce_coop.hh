@@ -57,13 +57,28 @@ public:
 
   omp_reduce_coop(unsigned exchange_period=10, bool eval_recv=false)
     : shared_individu(typename prob_t::sol_t(), std::numeric_limits<typename prob_t::eval_t>::max()),
-      xchange_op(exchange_period, &shared_individu, eval_recv)
+      epoch_slots(),
+      xchange_op(exchange_period, &shared_individu, epoch_slots, n_epoch_slots, eval_recv)
   {}
 
+  // the threads do not wait for each other to exchange, each one takes
+  // the best solution published so far for its exchange
+  void set_async(bool on) { xchange_op.set_async(on); }
+
+  // grow or shrink the exchange period online, between min_period and
+  // max_period (see adaptive_period). Only in the asynchronous mode.
+  void set_adaptive(unsigned min_period, unsigned max_period, double max_comm_ratio=0.05) { xchange_op.set_adaptive(min_period, max_period, max_comm_ratio); }
+
   typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se_in) {
     typename prob_t::soleval_t se(se_in);
     CHECK_EVAL(se);
 
+    // empty epochs for each run
+    if (xchange_op.async())
+      epoch_slots.reset(new epoch_slot<prob_t>[n_epoch_slots]);
+    // the first thread at the target stops the others, at the next
+    // exchange in the synchronous mode
+    termination::instance().open(!xchange_op.async());
 #pragma omp parallel 
     {
       typename prob_t::soleval_t tsol = se;  // REQUIS: sol must be copy constructible
@@ -76,6 +91,7 @@ public:
 	}
       }
     }
+    termination::instance().close();
 
     CHECK_EVAL(se);
     return se;
@@ -86,6 +102,10 @@ public:
 
 private:
   typename prob_t::soleval_t shared_individu;
+
+  // how far the threads can drift apart in the asynchronous mode
+  static const unsigned n_epoch_slots = 8;
+  boost::shared_array<epoch_slot<prob_t> > epoch_slots;
   
   omp_reduce_coop_op<prob_t> xchange_op;
 
@@ -65,14 +65,32 @@ public:
 
   omp_ring_coop(unsigned exchange_period=10, bool eval_recv=false)
     : shared_vect(new typename prob_t::soleval_t[omp_get_max_threads()]),
-      xchange_op(exchange_period, shared_vect, eval_recv)
+      mailboxes(),
+      xchange_op(exchange_period, shared_vect, mailboxes, eval_recv)
   {}
 
+  // exchange the solutions as deltas against the previous ones
+  void set_delta(bool on) { xchange_op.set_delta(on); }
+
+  // the threads do not wait for each other to exchange, they get the
+  // latest solution sent by the previous thread, if there is a new one
+  void set_async(bool on) { xchange_op.set_async(on); }
+
+  // grow or shrink the exchange period online, between min_period and
+  // max_period (see adaptive_period). Only in the asynchronous mode.
+  void set_adaptive(unsigned min_period, unsigned max_period, double max_comm_ratio=0.05) { xchange_op.set_adaptive(min_period, max_period, max_comm_ratio); }
+
   typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se_in) {
     typename prob_t::soleval_t se(se_in);
     CHECK_EVAL(se);
 
+    // empty mailboxes for each run
+    if (xchange_op.async())
+      mailboxes.reset(new typename omp_ring_coop_op<prob_t>::mailbox_t[omp_get_max_threads()]);
 
+    // the first thread at the target stops the others, at the next
+    // exchange in the synchronous mode
+    termination::instance().open(!xchange_op.async());
 #pragma omp parallel 
     {
       typename prob_t::soleval_t tsol = se;  // REQUIS: sol must be copy constructible
@@ -85,6 +103,7 @@ public:
 	}
       }
     }
+    termination::instance().close();
 
     CHECK_EVAL(se);
     return se;
@@ -95,6 +114,7 @@ public:
 
 private:
   boost::shared_array<typename prob_t::soleval_t> shared_vect;
+  boost::shared_array<typename omp_ring_coop_op<prob_t>::mailbox_t> mailboxes;
   
   omp_ring_coop_op<prob_t> xchange_op;
 
@@ -0,0 +1,133 @@
+#ifndef OMP_SNAPSHOT_HH
+#define OMP_SNAPSHOT_HH
+
+/*
+metl: A generic framework for sequential and parallel metaheuristics
+Copyright (c) 2005-2015, Sylvain Ouellet
+
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+
+*/
+
+#include <boost/shared_ptr.hpp>
+
+#ifdef _OPENMP
+#ifndef INCLUDED_OMP_H   
+#define INCLUDED_OMP_H   
+#include <omp.h>         
+#endif                   
+#else                    
+#include "omp_stub.h"    
+#endif
+
+namespace metl {
+
+// a pointer to an immutable object shared by the threads. The writers
+// replace the object, the readers take the current one and use it
+// without any lock held. The pointer itself is protected by a lock,
+// held only to copy it. A version counter is increased at every
+// replacement, so a reader that kept the object of the last version
+// does not need the lock to know it is still current.
+template <class T>
+class omp_snapshot {
+public:
+  typedef boost::shared_ptr<const T> pointer;
+
+  omp_snapshot(const pointer& p=pointer()) 
+    : _ptr(p), _version(0) 
+  { omp_init_lock(&_lock); }
+
+  // copies share the object, not the lock
+  omp_snapshot(const omp_snapshot& s)
+    : _ptr(s.load()), _version(0)
+  { omp_init_lock(&_lock); }
+
+  omp_snapshot& operator=(const omp_snapshot& s) {
+    if (this != &s) store(s.load());
+    return *this;
+  }
+
+  ~omp_snapshot() { omp_destroy_lock(&_lock); }
+
+  pointer load() const {
+    omp_set_lock(&_lock);
+    const pointer p(_ptr);
+    omp_unset_lock(&_lock);
+    return p;
+  }
+
+  void store(const pointer& p) {
+    pointer old;   // released once the lock is
+    omp_set_lock(&_lock);
+    old.swap(_ptr);
+    _ptr = p;
+    bump();
+    omp_unset_lock(&_lock);
+  }
+
+  // replaces the object by desired if it is still expected. Otherwise
+  // expected gets the current one.
+  bool compare_exchange(pointer& expected, const pointer& desired) {
+    pointer old;
+    omp_set_lock(&_lock);
+    const bool same = (_ptr == expected);
+    if (same) {
+      old.swap(_ptr);
+      _ptr = desired;
+      bump();
+    } else
+      expected = _ptr;
+    omp_unset_lock(&_lock);
+    return same;
+  }
+
+  unsigned long version() const {
+    unsigned long v;
+#pragma omp atomic read
+    v = _version;
+    return v;
+  }
+
+  // p and seen are what the caller got last time. They are updated if
+  // the object was replaced since, and the lock is only taken then.
+  bool refresh(pointer& p, unsigned long& seen) const {
+    if (version() == seen) return false;
+    omp_set_lock(&_lock);
+    p = _ptr;
+    seen = _version;
+    omp_unset_lock(&_lock);
+    return true;
+  }
+
+private:
+  void bump() {
+#pragma omp atomic
+    ++_version;
+  }
+
+  pointer _ptr;
+  unsigned long _version;   // written under the lock, read with omp atomic
+  mutable omp_lock_t _lock;
+};
+
+}
+
+#endif
@@ -1,10 +1,24 @@
 #ifndef OMP_STUB_H
 #define OMP_STUB_H
 //#warning COMPILED WITHOUT OMP SUPPORT
+#include <sys/time.h>
+
 inline int omp_get_num_threads() { return 1; }
 inline int omp_get_thread_num() { return 0; }
 inline int omp_get_max_threads() { return 1; }
+inline int omp_in_parallel() { return 0; }
+inline int omp_get_level() { return 0; }
+inline int omp_get_ancestor_thread_num(int level) { return level==0 ? 0 : -1; }
 inline void omp_set_num_threads(int t) {}
+inline double omp_get_wtime() {
+  timeval t;
+  gettimeofday(&t, 0);
+  return t.tv_sec + t.tv_usec*1e-6;
+}
 
 typedef int omp_lock_t;
+inline void omp_init_lock(omp_lock_t* l) {}
+inline void omp_destroy_lock(omp_lock_t* l) {}
+inline void omp_set_lock(omp_lock_t* l) {}
+inline void omp_unset_lock(omp_lock_t* l) {}
 #endif
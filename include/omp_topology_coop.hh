@@ -0,0 +1,117 @@
+#ifndef OMP_TOPOLOGY_COOP_HH
+#define OMP_TOPOLOGY_COOP_HH
+
+/*
+metl: A generic framework for sequential and parallel metaheuristics
+Copyright (c) 2005-2015, Sylvain Ouellet
+
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+
+*/
+
+#include "metl_def.hh"
+
+#ifdef _OPENMP
+#ifndef INCLUDED_OMP_H   
+#define INCLUDED_OMP_H   
+#include <omp.h>         
+#endif                   
+#else                    
+#include "omp_stub.h"    
+#endif
+
+
+#include "exchange_oper.hh"
+#include "topology.hh"
+
+#include <boost/shared_array.hpp>
+
+
+namespace metl {
+
+// island model: one copy of the metaheuristic per thread, exchanging
+// with their peers in _topology (ring_topology, torus_topology,
+// hypercube_topology, random_regular_topology, gossip_topology)
+template <class _metaheuristic, class _topology>
+class omp_topology_coop : public _metaheuristic {
+  typedef _metaheuristic base;
+  typedef typename _metaheuristic::problem_type prob_t;
+
+public:
+    using base::operator();
+    using base::generator;
+
+  omp_topology_coop(unsigned exchange_period=10, const _topology& topology=_topology(), bool eval_recv=false)
+    : published(),
+      xchange_op(exchange_period, published, topology, eval_recv)
+  {}
+
+  // grow or shrink the exchange period online, between min_period and
+  // max_period (see adaptive_period)
+  void set_adaptive(unsigned min_period, unsigned max_period, double max_comm_ratio=0.05) { xchange_op.set_adaptive(min_period, max_period, max_comm_ratio); }
+
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se_in) {
+    typename prob_t::soleval_t se(se_in);
+    CHECK_EVAL(se);
+
+    // nothing published at the start of a run
+    published.reset(new published_solution<prob_t>[omp_get_max_threads()]);
+
+    // the first thread at the target stops the others
+    termination::instance().open();
+#pragma omp parallel 
+    {
+      typename prob_t::soleval_t tsol = se;  // REQUIS: sol must be copy constructible
+      omp_topology_coop<_metaheuristic, _topology> thread_copy(*this);
+      tsol = thread_copy.runme(tsol);
+#pragma omp critical
+      {
+	if (tsol.second < se.second) {
+	  se = tsol;
+	}
+      }
+    }
+    termination::instance().close();
+
+    CHECK_EVAL(se);
+    return se;
+  }
+
+  const std::string name() const { return std::string("OpenMP ") + _topology().name() + " cooperative algorithme., base algorithm=(" + base::name()+")" ; }
+  
+
+private:
+  boost::shared_array<published_solution<prob_t> > published;
+  
+  omp_topology_coop_op<prob_t, _topology> xchange_op;
+
+  typename prob_t::soleval_t runme(const typename prob_t::soleval_t& se) {
+    return base::operator()(se, xchange_op);
+  }
+
+  // it is not possible to use 2 cooperative algorithm
+  template <class PE>
+  typename prob_t::soleval_t operator()(const typename prob_t::soleval_t& se_in, PE& periodic_exchange);
+};
+
+}
+
+#endif
@@ -30,6 +30,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "abstract_move.hh"
 #include <algorithm>
+#include <vector>
 
 namespace metl {
 
@@ -49,11 +50,28 @@ struct permutation_move : public abstract_move<prob_t> {
   inline unsigned get_i() const { return i; }
   inline unsigned get_j() const { return j; }
 
+  // the elements modified by the move (see move_cache.hh)
+  inline void writes(std::vector<unsigned>& elements) const {
+    elements.push_back(i);
+    elements.push_back(j);
+  }
+
 private:
   unsigned i,j;
 };  
 
 
+// two permutation moves conflict if they swap a common element (see
+// k_best_reduction)
+struct permutation_conflicts {
+  template <class _move>
+  inline bool operator()(const _move& a, const _move& b) const {
+    return a.get_i()==b.get_i() || a.get_i()==b.get_j() ||
+      a.get_j()==b.get_i() || a.get_j()==b.get_j();
+  }
+};
+
+
 }
 
 #endif
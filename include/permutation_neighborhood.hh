@@ -30,6 +30,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "permutation_move.hh"
 #include "separable_neighborhood.hh"
+#include "move_block.hh"
 
 namespace metl {
 
@@ -49,12 +50,17 @@ struct permutation_neighborhood: separable_neighborhood {
 
   template <class _oper>
   void iteration(_oper& op, const typename prob_t::sol_t& s, unsigned i) {
+    move_block<prob_t, _oper, move> blk(op, s);
     for (unsigned j=i+1; j<_size; ++j)
-      op(move(i,j));
+      blk(move(i,j));
+    blk.flush();
   }
 
   unsigned size() const { return _size; };
 
+  // iteration i evaluates the moves (i,j) for j>i
+  unsigned work(unsigned i) const { return _size-i-1; }
+
 private:
   const unsigned _size;
 };
@@ -0,0 +1,217 @@
+#ifndef PHILOX_RAND_HH
+#define PHILOX_RAND_HH
+
+/*
+metl: A generic framework for sequential and parallel metaheuristics
+Copyright (c) 2005-2015, Sylvain Ouellet
+
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+
+*/
+
+#include "metl_def.hh"
+
+#ifdef USE_MPI
+#ifdef HAVE_MPIPP_H     
+#include <mpi++.h>
+#else
+#include <mpi.h>
+#endif  // HAVE_MPIPP_H
+#endif  // USE_MPI
+
+#ifdef _OPENMP
+#ifndef INCLUDED_OMP_H   
+#define INCLUDED_OMP_H   
+#include <omp.h>         
+#endif                   
+#else                    
+#include "omp_stub.h"    
+#endif
+
+#include <vector>
+#include <cassert>
+#include <stddef.h>
+#include <string.h>
+#include "random_generator.hh"
+
+namespace metl {
+
+// the Philox4x32-10 generator of Salmon et al. (SC'11): the block n
+// of a stream is a bijection of the counter (n, thread, rank) under
+// the key, the seed. The streams of the threads and processes are
+// independent and a seed gives the same run again. No library needed.
+class philox_rand: public random_generator {
+ public:
+  philox_rand(unsigned long long seed=0x243F6A8885A308D3ULL)
+    : _seed(seed),
+      _rank(0)
+  {
+    // the slots do not share cache lines
+    size_t p = reinterpret_cast<size_t>(_raw);
+    _slots = reinterpret_cast<slot*>((p + cache_line-1) & ~size_t(cache_line-1));
+    rekey();
+  }
+
+  void init() {
+#ifdef USE_MPI
+    _rank = MPI::COMM_WORLD.Get_rank();
+#endif
+    rekey();
+  }
+
+  // restarts every stream from the new seed
+  void set_seed(unsigned long long seed) {
+    _seed = seed;
+    rekey();
+  }
+
+  unsigned long long seed() const { return _seed; }
+
+  // return a random number [0,1)
+  inline double operator()() {
+    state& s = current();
+    if (s.next==2) refill(s);
+    return s.out[s.next++];
+  }
+
+  // return a random number between 0 and N
+  inline unsigned operator()(unsigned N) {
+    return static_cast<unsigned>(N*operator()());
+  }
+
+  inline unsigned operator()(unsigned _min, unsigned _max) {
+    return operator()(_max-_min)+_min;
+  }
+
+  // the next n numbers [0,1) of the stream of the calling thread, the
+  // same as n calls
+  void fill(double* x, unsigned n) {
+    state& s = current();
+    while (n>0 && s.next<2) {
+      *x++ = s.out[s.next++];
+      --n;
+    }
+    for (; n>=2; n-=2, x+=2)
+      block(s, x);
+    if (n>0) {
+      refill(s);
+      *x = s.out[s.next++];
+    }
+  }
+
+  // appends the state of the stream of the calling thread to buf (for
+  // the checkpoints)
+  void pack(std::vector<char>& buf) const {
+    int n = sizeof(state);
+    const char* pn = reinterpret_cast<const char*>(&n);
+    buf.insert(buf.end(), pn, pn+sizeof(n));
+    const char* ps = reinterpret_cast<const char*>(&_slots[omp_get_thread_num()].s);
+    buf.insert(buf.end(), ps, ps+n);
+  }
+
+  // replaces the stream of the calling thread by the state at p,
+  // returns the end of the state
+  const char* unpack(const char* p) {
+    int n;
+    memcpy(&n, p, sizeof(n));
+    p += sizeof(n);
+    if (n!=int(sizeof(state))) return p+n;   // from another generator
+
+    memcpy(&current(), p, n);
+    return p+n;
+  }
+
+ private:
+  enum { cache_line=64 };
+
+  struct state {
+    double out[2];        // the numbers not given yet of the last block
+    unsigned next;        // 2 when out is used up
+    unsigned ctr[4];      // block index (2 words), thread, rank
+    unsigned key[2];
+  };
+
+  struct slot {
+    state s;
+    char pad[cache_line - sizeof(state)%cache_line];
+  };
+
+  inline state& current() {
+    assert(omp_get_thread_num()<MAX_THREADS);
+    return _slots[omp_get_thread_num()].s;
+  }
+
+  void rekey() {
+    for (int i=0; i<MAX_THREADS; ++i) {
+      state& s = _slots[i].s;
+      s.key[0] = static_cast<unsigned>(_seed & 0xFFFFFFFFULL);
+      s.key[1] = static_cast<unsigned>(_seed >> 32);
+      s.ctr[0] = 0;
+      s.ctr[1] = 0;
+      s.ctr[2] = i;
+      s.ctr[3] = _rank;
+      s.next = 2;
+    }
+  }
+
+  inline void refill(state& s) {
+    block(s, s.out);
+    s.next = 0;
+  }
+
+  // two numbers [0,1) of 53 bits from the block at the counter, moves
+  // to the next block
+  inline static void block(state& s, double* x) {
+    unsigned c0 = s.ctr[0], c1 = s.ctr[1], c2 = s.ctr[2], c3 = s.ctr[3];
+    unsigned k0 = s.key[0], k1 = s.key[1];
+
+    for (int r=0; r<10; ++r) {
+      const unsigned long long p0 = 0xD2511F53ULL * c0;
+      const unsigned long long p1 = 0xCD9E8D57ULL * c2;
+      const unsigned hi0 = static_cast<unsigned>(p0 >> 32), lo0 = static_cast<unsigned>(p0);
+      const unsigned hi1 = static_cast<unsigned>(p1 >> 32), lo1 = static_cast<unsigned>(p1);
+      c0 = hi1 ^ c1 ^ k0;
+      c1 = lo1;
+      c2 = hi0 ^ c3 ^ k1;
+      c3 = lo0;
+      k0 += 0x9E3779B9U;
+      k1 += 0xBB67AE85U;
+    }
+
+    const double two_m53 = 1.0/9007199254740992.0;
+    x[0] = ((c0 >> 5)*67108864.0 + (c1 >> 6)) * two_m53;
+    x[1] = ((c2 >> 5)*67108864.0 + (c3 >> 6)) * two_m53;
+
+    if (++s.ctr[0]==0) ++s.ctr[1];
+  }
+
+  unsigned long long _seed;
+  int _rank;
+  slot* _slots;
+  char _raw[(MAX_THREADS+1)*sizeof(slot)];
+
+  philox_rand& operator=(const philox_rand&);
+  philox_rand(const philox_rand&);
+};
+
+}
+
+#endif
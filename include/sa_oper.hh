@@ -27,6 +27,8 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 */
 
+#include "wire.hh"
+
 namespace metl {
 
 template <class prob_t, class _move>
@@ -39,6 +41,15 @@ struct sa_accept_scheme {
   }
 
   unsigned get_rejects() const { return reject; }
+  // resume from a checkpoint
+  void set_rejects(unsigned r) { reject = r; }
+
+  // the moves accepted or rejected since the last call
+  unsigned long take_evaluated() {
+    const unsigned long n = evaluated;
+    evaluated = 0;
+    return n;
+  }
 
   // FIXME: should realy be a friend function because it does not make sense to have it in the public interface
   void set_sol_and_eval(typename prob_t::sol_t* so , typename prob_t::eval_t* e)
@@ -53,7 +64,8 @@ protected:
     : s(0),
       T(temp), 
       _sol_eval(0),
-      reject(0)
+      reject(0),
+      evaluated(0)
   {}
 
   
@@ -61,11 +73,13 @@ protected:
     m(*s);
     *_sol_eval += e;
     reject=0;
+    ++evaluated;
     return true;
   }
 
   inline bool move_reject() {
     ++reject;
+    ++evaluated;
     return false;
   }
 
@@ -77,6 +91,7 @@ protected:
     // no assign T
     _sol_eval =r._sol_eval;
     reject = r.reject;
+    evaluated = r.evaluated;
 
     return *this;
   }
@@ -90,6 +105,7 @@ private:
   //  typename prob_t::eval_t& _sol_eval;
   typename prob_t::eval_t* _sol_eval;
   unsigned reject;
+  unsigned long evaluated;
 
   sa_accept_scheme(const sa_accept_scheme<prob_t, _move>&);
 };
@@ -163,6 +179,11 @@ struct cooling_scheme_base {
     return *this;
   }
 
+  // the state saved in the checkpoints. The schemes with more state
+  // extend them.
+  void encode(std::vector<char>& buf) const { wire<unsigned>::encode(it, buf); }
+  const char* decode(const char* p) { return wire<unsigned>::decode(p, it); }
+
 protected:
   cooling_scheme_base(double* temp)
     : T(temp),
@@ -204,6 +225,17 @@ struct cooling_geometric_steps : public cooling_scheme_base<_neighborhood> {
     sl = step_length; 
     next_step = step_length;
   }
+
+  // the position in the step, the parameters are not saved
+  void encode(std::vector<char>& buf) const {
+    cooling_scheme_base<_neighborhood>::encode(buf);
+    wire<unsigned>::encode(next_step, buf);
+  }
+
+  const char* decode(const char* p) {
+    p = cooling_scheme_base<_neighborhood>::decode(p);
+    return wire<unsigned>::decode(p, next_step);
+  }
   
   
   bool operator()() {    // returns true if temperature was modified
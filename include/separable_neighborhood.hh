@@ -27,6 +27,8 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <vector>
+
 namespace metl {
 
 struct separable_neighborhood {
@@ -42,6 +44,60 @@ struct separable_neighborhood {
   
 
   virtual unsigned size() const =0;
+
+  // estimate of the work done by iteration(op, sol, i), in any unit
+  // (number of moves for example). When it is defined, parallel
+  // evaluations split the neighborhood in chunks of equal work and
+  // use a static schedule. If it returns 0 for every index, there is
+  // no estimate.
+  virtual unsigned work(unsigned i) const { return 0; }
+};
+
+
+// static partition of a separable neighborhood in ranges of indices
+// that have about the same work. Range k is [begin(k), end(k)).
+class work_partition {
+public:
+  template<class _nh_t>
+  work_partition(const _nh_t& nh, unsigned parts)
+    : bounds(parts+1, 0)
+  {
+    const unsigned n = nh.size();
+    bounds[parts] = n;
+
+    double total = 0;
+    for (unsigned i=0; i<n; ++i)
+      total += nh.work(i);
+
+    if (total==0) {
+      bounds.clear();   // no estimate
+      return;
+    }
+
+    double acc = 0;
+    unsigned k = 1;
+    for (unsigned i=0; i<n && k<parts; ++i) {
+      const double w = nh.work(i);
+      // index i starts range k if less than half of it fits in range k-1
+      while (k<parts && acc + w/2 >= total*k/parts) {
+	bounds[k++] = i;
+      }
+      acc += w;
+    }
+    while (k<parts) {
+      bounds[k++] = n;
+    }
+  }
+
+  // false if the neighborhood does not estimate its work
+  bool balanced() const { return !bounds.empty(); }
+  unsigned parts() const { return bounds.size()-1; }
+
+  unsigned begin(unsigned k) const { return bounds[k]; }
+  unsigned end(unsigned k) const { return bounds[k+1]; }
+
+private:
+  std::vector<unsigned> bounds;
 };
 
 }
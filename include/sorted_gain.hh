@@ -0,0 +1,246 @@
+#ifndef SORTED_GAIN_HH
+#define SORTED_GAIN_HH
+
+/*
+metl: A generic framework for sequential and parallel metaheuristics
+Copyright (c) 2005-2015, Sylvain Ouellet
+
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+
+*/
+
+// a gain structure that keeps its moves sorted by cost, so the best
+// admissible move is found without looking at every move. Wrap the gain
+// structure of the problem:
+//
+//   tabu_gain<prob, move, sorted_gain<gain>, tabu_list> ts;
+//
+// The moves are kept in a tournament tree. A gain that logs the
+// entries its updates write (see abstract_gain::logs_changes) has only
+// their paths in the tree updated, the others have the whole tree
+// rebuilt after each update. gain_nh_eval then walks the moves by
+// increasing cost and stops as soon as no remaining move can be
+// selected (the first admissible one for tabu, the first one for
+// descent). This pays off when an update changes few entries, like the
+// gain of cells2switch. When most entries change (QAP), the update is
+// already linear and the plain gain is as fast.
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+namespace metl {
+
+
+// tournament tree over n values. Each node holds the index of the
+// smallest value of its subtree, the smallest index wins the ties.
+template <class eval_t>
+class tournament_tree {
+public:
+  tournament_tree() : _n(0), _p(1), _v(), _node(2, 0), _seen(2, 0), _pass(0) {}
+
+  // the values are set to max, call set() and rebuild()
+  void resize(unsigned n) {
+    _n = n;
+    _p = 1;
+    while (_p < n) _p*=2;
+    _v.assign(_p, std::numeric_limits<eval_t>::max());
+    _node.resize(2*_p);
+    _seen.assign(2*_p, 0);
+    _pass = 0;
+  }
+
+  unsigned size() const { return _n; }
+  inline const eval_t& value(unsigned k) const { return _v[k]; }
+
+  // set value k without updating the tree
+  inline void set(unsigned k, const eval_t& v) { _v[k] = v; }
+
+  // update the paths to the root of the values ks, set() before. The
+  // paths are updated a level at a time, so the nodes they share are
+  // only updated once.
+  void update(const std::vector<unsigned>& ks) {
+    if (++_pass == 0) {
+      std::fill(_seen.begin(), _seen.end(), 0);
+      _pass = 1;
+    }
+    _level.clear();
+    for (unsigned j=0; j<ks.size(); ++j)
+      visit((ks[j]+_p)/2, _level);
+
+    while (!_level.empty()) {
+      _up.clear();
+      for (unsigned j=0; j<_level.size(); ++j) {
+	const unsigned i = _level[j];
+	_node[i] = winner(_node[2*i], _node[2*i+1]);
+	if (i>1) visit(i/2, _up);
+      }
+      _level.swap(_up);
+    }
+  }
+
+  void rebuild() {
+    for (unsigned k=0; k<_p; ++k) 
+      _node[_p+k] = k;
+    for (unsigned i=_p-1; i>0; --i)
+      _node[i] = winner(_node[2*i], _node[2*i+1]);
+  }
+
+  // enumerate the values by increasing order (index for ties)
+  class walker {
+  public:
+    walker(const tournament_tree& t) : _t(t), _heap() {
+      _heap.reserve(64);
+      push(1);
+    }
+
+    // next index, false when done
+    bool next(unsigned& k) {
+      while (!_heap.empty()) {
+	std::pop_heap(_heap.begin(), _heap.end(), later(_t));
+	const unsigned i = _heap.back();
+	_heap.pop_back();
+	if (i >= _t._p) {
+	  k = i-_t._p;
+	  return true;
+	}
+	push(2*i);
+	push(2*i+1);
+      }
+      return false;
+    }
+
+  private:
+    struct later {
+      later(const tournament_tree& t) : _t(t) {}
+      bool operator()(unsigned a, unsigned b) const { 
+	return _t.before(_t._node[b], _t._node[a]); 
+      }
+      const tournament_tree& _t;
+    };
+
+    void push(unsigned i) {
+      if (_t._node[i] >= _t._n) return;    // only padding below
+      _heap.push_back(i);
+      std::push_heap(_heap.begin(), _heap.end(), later(_t));
+    }
+
+    const tournament_tree& _t;
+    std::vector<unsigned> _heap;
+  };
+
+private:
+  inline bool before(unsigned a, unsigned b) const {
+    return _v[a]<_v[b] || (!(_v[b]<_v[a]) && a<b);
+  }
+
+  inline unsigned winner(unsigned a, unsigned b) const {
+    return before(a, b) ? a : b;
+  }
+
+  inline void visit(unsigned i, std::vector<unsigned>& level) {
+    if (_seen[i] == _pass) return;
+    _seen[i] = _pass;
+    level.push_back(i);
+  }
+
+  friend class walker;
+
+  unsigned _n, _p;
+  std::vector<eval_t> _v;
+  std::vector<unsigned> _node;
+
+  // the nodes of the current update
+  std::vector<unsigned> _seen;
+  unsigned _pass;
+  std::vector<unsigned> _level, _up;
+};
+
+
+template <class _gain_t>
+class sorted_gain : public _gain_t {
+  typedef _gain_t base;
+
+public:
+  typedef typename base::move_t move_t;
+  typedef typename base::eval_t eval_t;
+
+  // the entries and the moves of the gain are taken here, the gain
+  // must not be resized after init
+  void init(const typename base::sol_t& sol) {
+    base::init(sol);
+
+    _entries.clear();
+    _moves.clear();
+    const typename base::iterator gend = base::end();
+    for (typename base::iterator i=base::begin(); i!=gend; ++i) {
+      _entries.push_back(&*i);
+      _moves.push_back(move_t(i));
+    }
+
+    _tree.resize(_entries.size());
+    rebuild();
+    base::log_changes(base::logs_changes());
+  }
+
+  // the entries written by update_before are in the log too
+  void update_after(const move_t& m, const typename base::sol_t& sol) {
+    base::update_after(m, sol);
+
+    if (!base::logs_changes()) {
+      rebuild();
+      return;
+    }
+
+    // update the paths of the changed entries, or the whole tree when
+    // there are many of them (a path costs a few nodes, their tops are
+    // shared)
+    const std::vector<unsigned>& changed = base::changes();
+    if (changed.size() > _entries.size()/4) {
+      rebuild();
+    } else {
+      for (unsigned i=0; i<changed.size(); ++i)
+	_tree.set(changed[i], *_entries[changed[i]]);
+      _tree.update(changed);
+    }
+    base::clear_changes();
+  }
+
+  inline const move_t& move(unsigned k) const { return _moves[k]; }
+  inline const eval_t& cost(unsigned k) const { return _tree.value(k); }
+  inline const tournament_tree<eval_t>& tree() const { return _tree; }
+
+private:
+  void rebuild() {
+    for (unsigned k=0; k<_entries.size(); ++k)
+      _tree.set(k, *_entries[k]);
+    _tree.rebuild();
+  }
+
+  std::vector<eval_t*> _entries;
+  std::vector<move_t> _moves;
+  tournament_tree<eval_t> _tree;
+};
+
+
+}
+
+#endif
@@ -49,6 +49,9 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
 #include <sprng.h>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
 #include "random_generator.hh"
 
 namespace metl {
@@ -99,6 +102,33 @@ class sprng_rand: public random_generator {
     return operator()(_max-_min)+_min;
   }
 
+  // appends the state of the stream of the calling thread to buf (for
+  // the checkpoints)
+  void pack(std::vector<char>& buf) const {
+    char* p = 0;
+    int n = pack_sprng(stream[omp_get_thread_num()], &p);
+    if (n<0 || p==0) n = 0;
+    const char* pn = reinterpret_cast<const char*>(&n);
+    buf.insert(buf.end(), pn, pn+sizeof(n));
+    buf.insert(buf.end(), p, p+n);
+    free(p);
+  }
+
+  // replaces the stream of the calling thread by the state at p,
+  // returns the end of the state
+  const char* unpack(const char* p) {
+    int n;
+    memcpy(&n, p, sizeof(n));
+    p += sizeof(n);
+    if (n==0) return p;
+
+    std::vector<char> packed(p, p+n);   // unpack_sprng does not take a const
+    int*& s = stream[omp_get_thread_num()];
+    if (s!=0) free_sprng(s);
+    s = unpack_sprng(&packed[0]);
+    return p+n;
+  }
+
  private:
   int* stream[MAX_THREADS];
   const int _gen_type;
@@ -108,9 +138,6 @@ class sprng_rand: public random_generator {
 
 };
 
-
-extern sprng_rand rng;
-
 }
 
 #endif
@@ -29,7 +29,9 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 
-#include <sprng.h>
+#include <limits>
+#include <vector>
+#include <string.h>
 #include "metl_def.hh"
 
 #ifdef _OPENMP
@@ -127,6 +129,29 @@ public:
 #endif
   }
 
+  // checkpoints (see checkpoint.hh): the state, same format as the
+  // streams of rng
+  void pack(std::vector<char>& buf) const {
+    const long x[6] = { x10, x11, x12, x20, x21, x22 };
+    const int n = sizeof(x);
+    const char* pn = reinterpret_cast<const char*>(&n);
+    buf.insert(buf.end(), pn, pn+sizeof(n));
+    const char* px = reinterpret_cast<const char*>(x);
+    buf.insert(buf.end(), px, px+n);
+  }
+
+  const char* unpack(const char* p) {
+    int n;
+    memcpy(&n, p, sizeof(n));
+    p += sizeof(n);
+    long x[6];
+    if (n!=int(sizeof(x))) return p+n;
+    memcpy(x, p, n);
+    x10 = x[0]; x11 = x[1]; x12 = x[2];
+    x20 = x[3]; x21 = x[4]; x22 = x[5];
+    return p+n;
+  }
+
 private:
   long x10, x11, x12, x20, x21, x22;
 };
@@ -0,0 +1,406 @@
+#ifndef TERMINATION_HH
+#define TERMINATION_HH
+
+/*
+metl: A generic framework for sequential and parallel metaheuristics
+Copyright (c) 2005-2015, Sylvain Ouellet
+
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+
+*/
+
+#include "metl_def.hh"
+
+#ifdef USE_MPI
+#ifdef HAVE_MPIPP_H     
+#include <mpi++.h>
+#else
+#include <mpi.h>
+#endif  // HAVE_MPIPP_H
+#include <vector>
+#include <string.h>
+#endif  // USE_MPI
+
+#ifdef _OPENMP
+#ifndef INCLUDED_OMP_H   
+#define INCLUDED_OMP_H   
+#include <omp.h>         
+#endif                   
+#else                    
+#include "omp_stub.h"    
+#endif
+
+namespace metl {
+
+// global early termination: when a thread or a process reaches the
+// target, the others stop too instead of running to the end of their
+// budgets. The search engines poll stopped() once per iteration, and
+// call raise() when they reach the target.
+//
+// The token is armed by the cooperations between open() and
+// close(). Outside of them raise() only lets the caller stop.
+//
+// The cooperations that exchange synchronously cannot let a
+// participant leave on its own, the others would wait for it
+// forever. They open the token collective: raise() only records the
+// request, and their operation stops everyone at the same exchange.
+// The requests travel with the exchanges themselves: agree() between
+// the barriers of the OpenMP operations, flags()/apply() in the
+// reduction of mpi_reduce_coop_op, and deadlines at the end of the
+// messages of the MPI ring and topology operations. They agree on the
+// checkpoints the same way (see checkpoint.hh).
+//
+// With open_mpi(), MPI is only called by the thread that initialized
+// it (MPI_THREAD_FUNNELED): the other threads stop the process, and
+// that thread tells the other processes at its next poll or in
+// close().
+class termination {
+public:
+  inline static termination& instance() { 
+    static termination _instance;
+    return _instance;
+  }
+
+  // also stop when a solution is at least as good as target, not only
+  // at the optimum of the problem
+  void set_target(double t) { _target = t; _has_target = true; }
+  void clear_target() { _has_target = false; }
+  bool has_target() const { return _has_target; }
+  double target() const { return _target; }
+
+  // arm the token for the threads of this process
+  void open(bool collective=false) {
+    _armed = true;
+    _collective = collective;
+    _stop = 0;
+    _pending = 0;
+    _want = 0;
+    _stop_at = never;
+    _checkpoint_at = never;
+  }
+
+  bool collective() const { return _collective; }
+
+#ifdef USE_MPI
+  // arm the token for all the processes, they are told with a message
+  // when one of them reaches the target. Collective call.
+  void open_mpi() {
+    open(false);
+    comm = MPI::COMM_WORLD.Dup();   // the messages do not mix with the exchanges
+    _mpi = true;
+    _raised = 0;
+    _sent = false;
+    _polls = 0;
+    _probed = 0;
+  }
+#endif
+
+  // disarm the token. Collective call if it was opened with open_mpi().
+  void close() {
+#ifdef USE_MPI
+    if (_mpi) {
+      // the stop may have been raised after the last poll
+      if (_raised) send_stop();
+
+      // every process that raised the token sent a message to each
+      // of the others
+      int sent = _sent ? 1 : 0, total = 0;
+      comm.Allreduce(&sent, &total, 1, MPI::INT, MPI::SUM);
+      char c;
+      for (int i=total-sent; i>0; --i)
+	comm.Recv(&c, 1, MPI::CHAR, MPI::ANY_SOURCE, tag_stop);
+      if (!_requests.empty())
+	MPI::Request::Waitall(_requests.size(), &_requests[0]);
+      _requests.clear();
+      comm.Free();
+      _mpi = false;
+    }
+#endif
+    _armed = false;
+    _collective = false;
+    _stop = 0;
+    _pending = 0;
+    _want = 0;
+    _stop_at = never;
+    _checkpoint_at = never;
+  }
+
+  // the caller reached the target. Returns true if it can stop now,
+  // false if it has to go on until the next exchange.
+  bool raise() {
+    if (!_armed) return true;
+    if (_collective) {
+#pragma omp atomic write
+      _pending = 1;
+      return false;
+    }
+#pragma omp atomic write
+    _stop = 1;
+#ifdef USE_MPI
+    if (_mpi) {
+#pragma omp atomic write
+      _raised = 1;
+      if (mpi_thread()) send_stop();
+    }
+#endif
+    return true;
+  }
+
+  // true when the search must stop
+  inline bool stopped() {
+    int s;
+#pragma omp atomic read
+    s = _stop;
+#ifdef USE_MPI
+    if (_mpi) {
+      // the polls of all the threads are counted
+      unsigned long n;
+#pragma omp atomic capture
+      n = ++_polls;
+      if (mpi_thread() && (s || n - _probed >= probe_period)) {
+	_probed = n;
+	int r;
+#pragma omp atomic read
+	r = _raised;
+	if (r) send_stop();   // maybe raised by another thread
+	if (!s) s = probe_stop();
+      }
+    }
+#endif
+    return s;
+  }
+
+  // collective mode: a participant wants a checkpoint. The epoch
+  // changes at the exchange where they agree, and they all write their
+  // checkpoint before their next exchange.
+  void want_checkpoint() {
+#pragma omp atomic write
+    _want = 1;
+  }
+
+  unsigned checkpoint_epoch() const {
+    unsigned e;
+#pragma omp atomic read
+    e = _epoch;
+    return e;
+  }
+
+  // synchronous OpenMP exchanges: every thread calls it between two
+  // barriers
+  void agree() {
+    if (!_collective) return;
+    int p;
+#pragma omp atomic read
+    p = _pending;
+    if (p) {
+#pragma omp atomic write
+      _stop = 1;
+    }
+    // the barrier that follows publishes the new epoch
+#pragma omp single nowait
+    {
+      if (_want) {
+	_want = 0;
+#pragma omp atomic
+	++_epoch;
+      }
+    }
+  }
+
+  // exchanges that reach every participant (a reduction): the
+  // requests of this one, to be or-ed with the others
+  enum { flag_stop=1, flag_checkpoint=2 };
+
+  unsigned flags() const {
+    if (!_collective) return 0;
+    int p, w;
+#pragma omp atomic read
+    p = _pending;
+#pragma omp atomic read
+    w = _want;
+    return (p ? flag_stop : 0) | (w ? flag_checkpoint : 0);
+  }
+
+  // the requests of all the participants, at the same exchange
+  void apply(unsigned f) {
+    if (f & flag_stop) {
+#pragma omp atomic write
+      _stop = 1;
+    }
+    if (f & flag_checkpoint) {
+#pragma omp atomic write
+      _want = 0;
+#pragma omp atomic
+      ++_epoch;
+    }
+  }
+
+#ifdef USE_MPI
+  // exchanges with the neighbours only: a request becomes a deadline,
+  // the exchange at which everyone acts on it. The participant that
+  // makes the request gives the exchange at which its messages have
+  // reached everyone (see topology_flood), and the deadlines travel at
+  // the end of the messages. Every participant keeps the earliest one
+  // it knows: the earliest of all is known by everyone when it comes.
+  // The calls are made by the thread that exchanges.
+  bool needs_deadline() const {
+    if (!_collective) return false;
+    int p, w;
+#pragma omp atomic read
+    p = _pending;
+#pragma omp atomic read
+    w = _want;
+    return (p && _stop_at==never) || (w && _checkpoint_at==never);
+  }
+
+  void propose(unsigned long exchange) {
+    if (exchange==never) return;
+    int p, w;
+#pragma omp atomic read
+    p = _pending;
+#pragma omp atomic read
+    w = _want;
+    if (p && exchange < _stop_at) _stop_at = exchange;
+    if (w && exchange < _checkpoint_at) _checkpoint_at = exchange;
+  }
+
+  void append_deadlines(std::vector<char>& buf) const {
+    const unsigned long d[2] = { _stop_at, _checkpoint_at };
+    const char* p = reinterpret_cast<const char*>(d);
+    buf.insert(buf.end(), p, p+sizeof(d));
+  }
+
+  // the deadlines at the end of a message
+  void merge_deadlines(const std::vector<char>& buf) {
+    unsigned long d[2];
+    memcpy(d, &buf[buf.size() - sizeof(d)], sizeof(d));
+    if (d[0] < _stop_at) _stop_at = d[0];
+    if (d[1] < _checkpoint_at) _checkpoint_at = d[1];
+  }
+
+  // after the messages of the exchange were received
+  void reached(unsigned long exchange) {
+    if (_stop_at <= exchange) {
+#pragma omp atomic write
+      _stop = 1;
+    }
+    if (_checkpoint_at <= exchange) {
+      _checkpoint_at = never;
+#pragma omp atomic write
+      _want = 0;
+#pragma omp atomic
+      ++_epoch;
+    }
+  }
+#endif
+
+  static const unsigned long never = ~0ul;
+
+private:
+#ifdef USE_MPI
+  // the thread that initialized MPI: thread 0 of every enclosing team
+  static bool mpi_thread() {
+    for (int l=omp_get_level(); l>0; --l)
+      if (omp_get_ancestor_thread_num(l)!=0) return false;
+    return true;
+  }
+
+  // the calls below are made by mpi_thread() only
+  void send_stop() {
+#pragma omp critical (TERMINATION_MPI)
+    {
+      if (!_sent) {
+	_sent = true;
+	const int rank = comm.Get_rank();
+	const int size = comm.Get_size();
+	for (int r=0; r<size; ++r)
+	  if (r!=rank) _requests.push_back(comm.Isend(&_one, 1, MPI::CHAR, r, tag_stop));
+      }
+    }
+  }
+
+  // a message from another process
+  bool probe_stop() {
+    bool got;
+#pragma omp critical (TERMINATION_MPI)
+    got = comm.Iprobe(MPI::ANY_SOURCE, tag_stop);
+    if (got) {
+#pragma omp atomic write
+      _stop = 1;
+    }
+    return got;
+  }
+#endif
+
+  termination()
+    : _target(0), _has_target(false),
+      _armed(false), _collective(false),
+      _stop(0), _pending(0), _want(0), _epoch(0),
+      _stop_at(never), _checkpoint_at(never)
+#ifdef USE_MPI
+    , comm(), _mpi(false), _raised(0), _sent(false), _one(1), _polls(0), _probed(0), _requests()
+#endif
+  {}
+
+  termination(const termination&);
+  termination& operator=(const termination&);
+
+  double _target;
+  bool _has_target;
+  bool _armed;
+  bool _collective;
+  int _stop;         // only accessed with omp atomic
+  int _pending;      // collective mode: someone reached the target
+  int _want;         // collective mode: someone wants a checkpoint
+  unsigned _epoch;   // of the agreed checkpoints
+  unsigned long _stop_at;         // exchange deadlines, never if none
+  unsigned long _checkpoint_at;
+
+#ifdef USE_MPI
+  static const int tag_stop = 0;
+  static const unsigned probe_period = 16;   // polls between two Iprobe
+
+  MPI::Intracomm comm;
+  bool _mpi;
+  int _raised;       // this process reached the target, only accessed with omp atomic
+  bool _sent;
+  char _one;
+  unsigned long _polls;    // only accessed with omp atomic
+  unsigned long _probed;   // _polls at the last probe, mpi_thread() only
+  std::vector<MPI::Request> _requests;
+#endif
+};
+
+
+// the evaluation at which a search stops: the optimum of the problem,
+// or the target of the termination token if it is easier
+template <class prob_t>
+typename prob_t::eval_t termination_target() {
+  const typename prob_t::eval_t opt = prob_t::instance().optimum();
+  const termination& t = termination::instance();
+  if (t.has_target() && t.target() > opt)
+    return static_cast<typename prob_t::eval_t>(t.target());
+  return opt;
+}
+
+}
+
+#endif
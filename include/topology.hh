@@ -0,0 +1,236 @@
+#ifndef TOPOLOGY_HH
+#define TOPOLOGY_HH
+
+/*
+metl: A generic framework for sequential and parallel metaheuristics
+Copyright (c) 2005-2015, Sylvain Ouellet
+
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+
+*/
+
+// migration topologies for the island cooperations
+// (omp_topology_coop_op, mpi_topology_coop_op).
+//
+//   topo.peers(rank, size, epoch, to, from)
+//
+// gives the islands that island rank sends its solution to and receives
+// from at its exchange number epoch. Every island computes the same
+// graph, so if i sends to j, j receives from i. The random topologies
+// only depend on their seed and the epoch.
+
+#include <vector>
+#include <algorithm>
+
+namespace metl {
+
+// a generator that gives the same numbers on every process (splitmix64)
+class topology_rng {
+public:
+  topology_rng(unsigned long long seed) : x(seed) {}
+
+  unsigned long long next() {
+    unsigned long long z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  // in [0,n)
+  unsigned operator()(unsigned n) { return next() % n; }
+
+private:
+  unsigned long long x;
+};
+
+
+// Fisher-Yates with topology_rng, the same on every process
+inline void topology_shuffle(std::vector<unsigned>& v, topology_rng& r) {
+  for (unsigned i=v.size(); i>1; --i)
+    std::swap(v[i-1], v[r(i)]);
+}
+
+
+// ceil(log2(size))
+inline unsigned topology_log2(unsigned size) {
+  unsigned l=0;
+  while ((1u<<l) < size) ++l;
+  return l;
+}
+
+
+// the islands of an undirected graph are both sent to and received from
+inline void topology_symmetric(std::vector<unsigned>& to, std::vector<unsigned>& from, unsigned rank) {
+  std::sort(to.begin(), to.end());
+  to.erase(std::unique(to.begin(), to.end()), to.end());
+  to.erase(std::remove(to.begin(), to.end(), rank), to.end());
+  from = to;
+}
+
+
+// the exchange after which every island knows what island rank sent
+// at exchange epoch, each island passing it on at its next
+// exchanges. ~0ul if that takes more than 64*size exchanges.
+template <class _topology>
+unsigned long topology_flood(const _topology& topo, unsigned rank, unsigned size, unsigned long epoch) {
+  if (size<2) return epoch;
+
+  std::vector<bool> known(size, false), next;
+  std::vector<unsigned> to, from;
+  known[rank] = true;
+  unsigned count = 1;
+  for (unsigned long e=epoch; e<epoch+64ul*size; ++e) {
+    next = known;
+    for (unsigned i=0; i<size; ++i) {
+      if (!known[i]) continue;
+      topo.peers(i, size, e, to, from);
+      for (unsigned j=0; j<to.size(); ++j) {
+	if (!next[to[j]]) {
+	  next[to[j]] = true;
+	  ++count;
+	}
+      }
+    }
+    known.swap(next);
+    if (count==size) return e;
+  }
+  return ~0ul;
+}
+
+
+// the ring of mpi_ring_coop_op and omp_ring_coop_op, one peer
+struct ring_topology {
+  void peers(unsigned rank, unsigned size, unsigned long, std::vector<unsigned>& to, std::vector<unsigned>& from) const {
+    to.clear();
+    from.clear();
+    if (size<2) return;
+    to.push_back(rank==size-1 ? 0 : rank+1);
+    from.push_back(rank==0 ? size-1 : rank-1);
+  }
+
+  const char* name() const { return "ring"; }
+};
+
+
+// rows x cols torus with rows the largest divisor of size not above
+// its square root. Up to 4 peers.
+struct torus_topology {
+  void peers(unsigned rank, unsigned size, unsigned long, std::vector<unsigned>& to, std::vector<unsigned>& from) const {
+    to.clear();
+    unsigned rows=1;
+    for (unsigned r=1; r*r<=size; ++r)
+      if (size%r==0) rows=r;
+    const unsigned cols=size/rows;
+    const unsigned i=rank/cols, j=rank%cols;
+
+    to.push_back(((i+rows-1)%rows)*cols + j);
+    to.push_back(((i+1)%rows)*cols + j);
+    to.push_back(i*cols + (j+cols-1)%cols);
+    to.push_back(i*cols + (j+1)%cols);
+    topology_symmetric(to, from, rank);
+  }
+
+  const char* name() const { return "torus"; }
+};
+
+
+// the islands whose rank differs by one bit. When size is not a power
+// of 2, the missing islands are skipped. log2(size) peers.
+struct hypercube_topology {
+  void peers(unsigned rank, unsigned size, unsigned long, std::vector<unsigned>& to, std::vector<unsigned>& from) const {
+    to.clear();
+    for (unsigned b=0; (1u<<b)<size; ++b) {
+      const unsigned p = rank ^ (1u<<b);
+      if (p<size) to.push_back(p);
+    }
+    topology_symmetric(to, from, rank);
+  }
+
+  const char* name() const { return "hypercube"; }
+};
+
+
+// union of degree/2 random Hamiltonian cycles, fixed for the whole
+// search. The default degree is about log2(size). Cycles that share an
+// edge give a slightly smaller degree.
+struct random_regular_topology {
+  random_regular_topology(unsigned long long _seed=1, unsigned _degree=0) 
+    : seed(_seed), degree(_degree) 
+  {}
+
+  void peers(unsigned rank, unsigned size, unsigned long, std::vector<unsigned>& to, std::vector<unsigned>& from) const {
+    to.clear();
+    if (size<2) {
+      from.clear();
+      return;
+    }
+    const unsigned d = degree>0 ? degree : std::max(2u, topology_log2(size));
+    topology_rng r(seed);
+    std::vector<unsigned> cycle(size), pos(size);
+    for (unsigned c=0; c<(d+1)/2; ++c) {
+      for (unsigned i=0; i<size; ++i) cycle[i]=i;
+      topology_shuffle(cycle, r);
+      for (unsigned i=0; i<size; ++i) pos[cycle[i]]=i;
+      to.push_back(cycle[(pos[rank]+1)%size]);
+      to.push_back(cycle[(pos[rank]+size-1)%size]);
+    }
+    topology_symmetric(to, from, rank);
+  }
+
+  const char* name() const { return "random regular"; }
+
+  unsigned long long seed;
+  unsigned degree;
+};
+
+
+// a new random perfect matching at each epoch: each island exchanges
+// with one random peer (none for one island when size is odd).
+struct gossip_topology {
+  gossip_topology(unsigned long long _seed=1) : seed(_seed) {}
+
+  void peers(unsigned rank, unsigned size, unsigned long epoch, std::vector<unsigned>& to, std::vector<unsigned>& from) const {
+    to.clear();
+    from.clear();
+    if (size<2) return;
+
+    topology_rng r(seed ^ (0x2545F4914F6CDD1DULL*(epoch+1)));
+    std::vector<unsigned> perm(size);
+    for (unsigned i=0; i<size; ++i) perm[i]=i;
+    topology_shuffle(perm, r);
+
+    // pairs (perm[0],perm[1]), (perm[2],perm[3]) ...
+    const unsigned i = std::find(perm.begin(), perm.end(), rank) - perm.begin();
+    const unsigned p = i^1u;
+    if (p<size) {
+      to.push_back(perm[p]);
+      from.push_back(perm[p]);
+    }
+  }
+
+  const char* name() const { return "gossip"; }
+
+  unsigned long long seed;
+};
+
+}
+
+#endif
@@ -0,0 +1,420 @@
+#ifndef WIRE_HH
+#define WIRE_HH
+
+/*
+metl: A generic framework for sequential and parallel metaheuristics
+Copyright (c) 2005-2015, Sylvain Ouellet
+
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. 
+
+*/
+
+// how solutions are put in the messages exchanged by the processes.
+//
+//   metl::wire<T>::encode(x, buf)   appends x to buf
+//   metl::wire<T>::decode(p, x)     reads x at p, returns the end of x
+//
+// PODs and vectors of PODs are copied as they are in memory, pairs,
+// other vectors and matrices element by element. The other types fall
+// back on boost serialization. A problem can give its own flat format
+// by specializing metl::wire for its solution type, and must do so for
+// its tabu list, which is saved in the checkpoints.
+//
+// A solution can also be sent as a delta against the previous one sent
+// to the same peer (see delta_channel):
+//
+//   metl::wire_delta<T>::encode(ref, x, buf)   appends x as a delta against ref
+//   metl::wire_delta<T>::decode(p, x)          patches x (which holds ref) 
+//   metl::wire_delta<T>::assign(x, y)          x=y, writing only what differs
+//
+// vectors of PODs send their changed positions, the other types are
+// sent in full.
+
+#include <vector>
+#include <utility>
+#include <string>
+#include <sstream>
+#include <string.h>
+#include <assert.h>
+
+// this is a workaround for a bug in BOOST 1_32. 
+// If your compiler does not support exceptions or you want to compile without exceptions, then define BOOST_NO_EXCEPTIONS.
+#ifdef BOOST_NO_EXCEPTIONS
+#undef BOOST_NO_EXCEPTIONS
+#include <boost/archive/archive_exception.hpp>
+#define BOOST_NO_EXCEPTIONS
+#endif
+
+#include <boost/type_traits/is_pod.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/utility.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include "Matrix.hh"
+
+namespace metl {
+
+
+// copy of the bytes of a POD
+template <class T, bool pod=boost::is_pod<T>::value>
+struct wire_impl {
+  static void encode(const T& x, std::vector<char>& buf) {
+    const char* p = reinterpret_cast<const char*>(&x);
+    buf.insert(buf.end(), p, p+sizeof(T));
+  }
+
+  static const char* decode(const char* p, T& x) {
+    memcpy(&x, p, sizeof(T));
+    return p+sizeof(T);
+  }
+};
+
+
+// boost serialization, the archive is preceded by its size
+template <class T>
+struct wire_impl<T, false> {
+  static void encode(const T& x, std::vector<char>& buf) {
+    std::ostringstream os(std::ios::binary);
+    {
+      boost::archive::binary_oarchive oa(os, boost::archive::no_header);
+      oa << x;
+    }
+    const std::string s = os.str();
+    wire_impl<unsigned>::encode(s.size(), buf);
+    buf.insert(buf.end(), s.begin(), s.end());
+  }
+
+  static const char* decode(const char* p, T& x) {
+    unsigned n;
+    p = wire_impl<unsigned>::decode(p, n);
+    std::istringstream is(std::string(p, n), std::ios::binary);
+    boost::archive::binary_iarchive ia(is, boost::archive::no_header);
+    ia >> x;
+    return p+n;
+  }
+};
+
+
+template <class T>
+struct wire : public wire_impl<T> {};
+
+
+// vectors: the number of elements, then the elements
+template <class T, bool pod=boost::is_pod<T>::value>
+struct wire_vector {
+  static void encode(const std::vector<T>& x, std::vector<char>& buf) {
+    wire<unsigned>::encode(x.size(), buf);
+    if (x.empty()) return;
+    const char* p = reinterpret_cast<const char*>(&x[0]);
+    buf.insert(buf.end(), p, p+x.size()*sizeof(T));
+  }
+
+  static const char* decode(const char* p, std::vector<T>& x) {
+    unsigned n;
+    p = wire<unsigned>::decode(p, n);
+    x.resize(n);
+    if (n==0) return p;
+    memcpy(&x[0], p, n*sizeof(T));
+    return p+n*sizeof(T);
+  }
+};
+
+
+template <class T>
+struct wire_vector<T, false> {
+  static void encode(const std::vector<T>& x, std::vector<char>& buf) {
+    wire<unsigned>::encode(x.size(), buf);
+    for (unsigned i=0; i<x.size(); ++i)
+      wire<T>::encode(x[i], buf);
+  }
+
+  static const char* decode(const char* p, std::vector<T>& x) {
+    unsigned n;
+    p = wire<unsigned>::decode(p, n);
+    x.resize(n);
+    for (unsigned i=0; i<n; ++i)
+      p = wire<T>::decode(p, x[i]);
+    return p;
+  }
+};
+
+
+// vector<bool> does not store bools
+template <>
+struct wire_vector<bool, true> {
+  static void encode(const std::vector<bool>& x, std::vector<char>& buf) {
+    wire<unsigned>::encode(x.size(), buf);
+    for (unsigned i=0; i<x.size(); ++i)
+      buf.push_back(x[i]);
+  }
+
+  static const char* decode(const char* p, std::vector<bool>& x) {
+    unsigned n;
+    p = wire<unsigned>::decode(p, n);
+    x.resize(n);
+    for (unsigned i=0; i<n; ++i)
+      x[i] = p[i]!=0;
+    return p+n;
+  }
+};
+
+
+template <class T>
+struct wire<std::vector<T> > : public wire_vector<T> {};
+
+
+template <class A, class B>
+struct wire<std::pair<A, B> > {
+  static void encode(const std::pair<A, B>& x, std::vector<char>& buf) {
+    wire<A>::encode(x.first, buf);
+    wire<B>::encode(x.second, buf);
+  }
+
+  static const char* decode(const char* p, std::pair<A, B>& x) {
+    p = wire<A>::decode(p, x.first);
+    return wire<B>::decode(p, x.second);
+  }
+};
+
+
+// matrices: the elements row by row, the matrix read must already have
+// the same dimensions
+template <class T>
+struct wire<Matrix<T> > {
+  static void encode(const Matrix<T>& x, std::vector<char>& buf) {
+    for (unsigned i=0; i<x.get_rows(); ++i)
+      for (unsigned j=0; j<x.get_cols(); ++j)
+	wire<T>::encode(x(i,j), buf);
+  }
+
+  static const char* decode(const char* p, Matrix<T>& x) {
+    for (unsigned i=0; i<x.get_rows(); ++i)
+      for (unsigned j=0; j<x.get_cols(); ++j)
+	p = wire<T>::decode(p, x(i,j));
+    return p;
+  }
+};
+
+
+// the deltas start with the number of changed positions, or with
+// wire_delta_full if the solution follows in full.
+const unsigned wire_delta_full = ~0u;
+
+// the solution in full
+template <class T>
+struct wire_delta_copy {
+  static void encode(const T& , const T& x, std::vector<char>& buf) {
+    wire<unsigned>::encode(wire_delta_full, buf);
+    wire<T>::encode(x, buf);
+  }
+
+  static const char* decode(const char* p, T& x) {
+    unsigned k;
+    p = wire<unsigned>::decode(p, k);
+    assert(k==wire_delta_full);
+    return wire<T>::decode(p, x);
+  }
+
+  static void assign(T& x, const T& y) { x = y; }
+};
+
+template <class T>
+struct wire_delta : public wire_delta_copy<T> {};
+
+
+// the changed positions with their values. The solution is sent in
+// full when the delta would not be smaller.
+template <class T, bool pod=boost::is_pod<T>::value>
+struct wire_delta_vector {
+  static unsigned changes(const std::vector<T>& ref, const std::vector<T>& x) {
+    if (ref.size()!=x.size()) return wire_delta_full;
+
+    // above this, the delta is bigger than the vector
+    const unsigned max_changes = x.size()*sizeof(T) / (sizeof(unsigned)+sizeof(T));
+    unsigned k=0;
+    for (unsigned i=0; i<x.size(); ++i) {
+      if (memcmp(&x[i], &ref[i], sizeof(T))!=0 && ++k>=max_changes) 
+	return wire_delta_full;
+    }
+    return k;
+  }
+
+  static void encode(const std::vector<T>& ref, const std::vector<T>& x, std::vector<char>& buf) {
+    const unsigned k = changes(ref, x);
+    wire<unsigned>::encode(k, buf);
+    if (k==wire_delta_full) {
+      wire<std::vector<T> >::encode(x, buf);
+      return;
+    }
+    for (unsigned i=0; i<x.size(); ++i) {
+      if (memcmp(&x[i], &ref[i], sizeof(T))!=0) {
+	wire<unsigned>::encode(i, buf);
+	wire<T>::encode(x[i], buf);
+      }
+    }
+  }
+
+  static const char* decode(const char* p, std::vector<T>& x) {
+    unsigned k;
+    p = wire<unsigned>::decode(p, k);
+    if (k==wire_delta_full) 
+      return wire<std::vector<T> >::decode(p, x);
+
+    for (unsigned j=0; j<k; ++j) {
+      unsigned i;
+      p = wire<unsigned>::decode(p, i);
+      assert(i<x.size());
+      p = wire<T>::decode(p, x[i]);
+    }
+    return p;
+  }
+
+  // does not touch the cache lines that do not change
+  static void assign(std::vector<T>& x, const std::vector<T>& y) {
+    if (x.size()!=y.size()) {
+      x = y;
+      return;
+    }
+    for (unsigned i=0; i<y.size(); ++i) {
+      if (memcmp(&x[i], &y[i], sizeof(T))!=0) 
+	x[i] = y[i];
+    }
+  }
+};
+
+
+template <class T>
+struct wire_delta_vector<T, false> : public wire_delta_copy<std::vector<T> > {};
+
+template <>
+struct wire_delta_vector<bool, true> : public wire_delta_copy<std::vector<bool> > {};
+
+
+template <class T>
+struct wire_delta<std::vector<T> > : public wire_delta_vector<T> {};
+
+
+
+// a solution with its evaluation
+template <class prob_t>
+inline void wire_encode(const typename prob_t::soleval_t& se, std::vector<char>& buf) {
+  buf.clear();
+  wire<typename prob_t::sol_t>::encode(se.first, buf);
+  wire<typename prob_t::eval_t>::encode(se.second, buf);
+}
+
+template <class prob_t>
+inline void wire_decode(const char* p, typename prob_t::soleval_t& se) {
+  p = wire<typename prob_t::sol_t>::decode(p, se.first);
+  wire<typename prob_t::eval_t>::decode(p, se.second);
+}
+
+
+// the solutions sent to and received from each peer of a channel. When
+// it is enabled, the solutions are sent as deltas against the last one
+// sent to the same peer, the first one is sent in full. The messages
+// between two peers must be received in the order they are sent.
+// When it is disabled, the messages are those of wire_encode().
+template <class prob_t>
+class delta_channel {
+  typedef typename prob_t::sol_t sol_t;
+  typedef typename prob_t::eval_t eval_t;
+public:
+  delta_channel() 
+    : _sent(), _recv(), _has_sent(), _enabled(false) 
+  {}
+
+  void enable(unsigned peers) {
+    _sent.assign(peers, sol_t());
+    _recv.assign(peers, sol_t());
+    _has_sent.assign(peers, false);
+    _enabled = true;
+  }
+
+  void disable() {
+    _sent.clear();
+    _recv.clear();
+    _has_sent.clear();
+    _enabled = false;
+  }
+
+  bool enabled() const { return _enabled; }
+
+  void encode(unsigned peer, const typename prob_t::soleval_t& se, std::vector<char>& buf) {
+    if (!_enabled) {
+      wire_encode<prob_t>(se, buf);
+      return;
+    }
+    assert(peer<_sent.size());
+
+    buf.clear();
+    if (_has_sent[peer]) {
+      buf.push_back(1);
+      wire_delta<sol_t>::encode(_sent[peer], se.first, buf);
+    } else {
+      buf.push_back(0);
+      wire<sol_t>::encode(se.first, buf);
+      _has_sent[peer] = true;
+    }
+    wire<eval_t>::encode(se.second, buf);
+    wire_delta<sol_t>::assign(_sent[peer], se.first);
+  }
+
+  // a message that does not depend on the previous ones, for the last
+  // message sent to a peer
+  void encode_full(const typename prob_t::soleval_t& se, std::vector<char>& buf) const {
+    if (!_enabled) {
+      wire_encode<prob_t>(se, buf);
+      return;
+    }
+    buf.clear();
+    buf.push_back(0);
+    wire<sol_t>::encode(se.first, buf);
+    wire<eval_t>::encode(se.second, buf);
+  }
+
+  void decode(unsigned peer, const char* p, typename prob_t::soleval_t& se) {
+    if (!_enabled) {
+      wire_decode<prob_t>(p, se);
+      return;
+    }
+    assert(peer<_recv.size());
+
+    if (*p++)
+      p = wire_delta<sol_t>::decode(p, _recv[peer]);
+    else
+      p = wire<sol_t>::decode(p, _recv[peer]);
+    wire<eval_t>::decode(p, se.second);
+    se.first = _recv[peer];
+  }
+
+private:
+  std::vector<sol_t> _sent;      // last solution sent to each peer
+  std::vector<sol_t> _recv;      // last solution received from each peer
+  std::vector<bool> _has_sent;
+  bool _enabled;
+};
+
+
+}
+
+#endif
@@ -8,6 +8,7 @@ set voisinage {*neighborhood}
 set gain {*gain}
 set liste_tabu {*tabu_list}
 set generateur {*init_sol_gen}
+set conflits {*move_conflicts}
 #set croisement {*uniform_xover<problem> *single_point_xover<problem> *two_point_xover<problem>}
 set croisement {*uniform_xover<problem>}
 #set accept_scheme {*metropolis<problem,mouvement> *threshold_accept<problem,mouvement>}
@@ -31,12 +32,17 @@ set algo_voisinage {
     *descent<problem,mouvement,voisinage,generateur> 
     *descent_gain<problem,mouvement,gain,generateur> 
     *descent_fm<problem,mouvement,voisinage,generateur> 
+    *descent_fm_ns_omp<problem,mouvement,voisinage,generateur> 
     *descent_ns_omp<problem,mouvement,voisinage,generateur> 
+    *descent_ns_omp_pool<problem,mouvement,voisinage,generateur> 
+    *descent_multi<problem,mouvement,voisinage,conflits,generateur> 
+    *descent_multi_ns_omp<problem,mouvement,voisinage,conflits,generateur> 
     *descent_ns_mpi<problem,mouvement,voisinage,generateur>
     *simulated_annealing<problem,mouvement,voisinage,generateur,accept_scheme,cooling_scheme> 
     *tabu<problem,mouvement,voisinage,liste_tabu,generateur>
     *tabu_gain<problem,mouvement,gain,liste_tabu,generateur> 
     *tabu_ns_omp<problem,mouvement,voisinage,liste_tabu,generateur> 
+    *tabu_ns_omp_pool<problem,mouvement,voisinage,liste_tabu,generateur> 
     *tabu_ns_mpi<problem,mouvement,voisinage,liste_tabu,generateur> 
 }
 
@@ -48,9 +54,20 @@ set algo_sa {
     *simulated_annealing<problem,mouvement,voisinage,generateur,accept_scheme,cooling_scheme> 
 }
 
+# these need a move with reads() and writes() (move_cache.hh) or a
+# separable_gain. Only the qap concepts provide them, see below.
+set algo_qap {
+    *descent_cache<problem,mouvement,voisinage,generateur> 
+    *descent_cache_ns_omp<problem,mouvement,voisinage,generateur> 
+    *descent_gain_ns_omp<problem,mouvement,gain,generateur> 
+    *tabu_cache<problem,mouvement,voisinage,liste_tabu,generateur> 
+    *tabu_cache_ns_omp<problem,mouvement,voisinage,liste_tabu,generateur> 
+    *tabu_gain_ns_omp<problem,mouvement,gain,liste_tabu,generateur> 
+}
+
 
 set algo [concat $algo_voisinage $algo_evolution]
-set coop {*omp_blackboard_coop *omp_ring_coop *omp_reduce_coop *mpi_blackboard_coop *mpi_ring_coop *mpi_reduce_coop}
+set coop {*omp_blackboard_coop *omp_ring_coop *omp_reduce_coop *mpi_blackboard_coop *mpi_rma_blackboard_coop *mpi_ring_coop *mpi_reduce_coop *hybrid_coop}
 
 
 ########### this functions makes recurcives substitutions from the
@@ -158,8 +175,15 @@ set mutation {*mutation}
 set croisement {*path_xover_swap<problem,mouvement> *path_xover_insert<problem>}
 set l_crossover2 [expand algo_evolution]
 
+set old_gen $generateur
+set generateur {*qap_gen}
+set l_qap [expand algo_qap]
+set generateur $old_gen
+set algo_for_coop [l_filter $l_qap "^.descent"]
+set l_qap_coop [expand coop<algo_for_coop>]
+
 
-set algo_list [concat $algo_list $l_crossover $l_accept $l_selection $l_remplacement $l_crossover2]
+set algo_list [concat $algo_list $l_crossover $l_accept $l_selection $l_remplacement $l_crossover2 $l_qap $l_qap_coop]
 
 
 